@@ -76,8 +76,6 @@ struct channel {
 	struct disk devices[2];     /* The devices on this channel. */
 };
 
-/* We support the two "legacy" ATA channels found in a standard PC. */
-#define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
 
 static void reset_channel (struct channel *);
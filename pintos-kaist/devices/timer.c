@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* 8254 타이머 칩의 세부 사항은 [8254]를 참고한다. */
 
@@ -20,10 +21,62 @@
 /* OS 부팅 이후 지난 타이머 틱 수. */
 static int64_t ticks;
 
+/* 8254 입력 주파수와, 한 틱에 해당하는 카운터 값 (반올림). */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+/* 16비트 카운터로 한 번에 건너뛸 수 있는 최대 틱 수 */
+#define TICKLESS_MAX (0xffff / PIT_COUNT)
+
+/* -tickless 커널 옵션. idle일 때 주기 인터럽트를 멈춘다. */
+bool timer_tickless;
+
+/* one-shot 모드로 건너뛰는 중이면 그 틱 수, 주기 모드면 0.
+   tickless_count는 그때 카운터에 넣은 값. */
+static int tickless_ticks;
+static uint16_t tickless_count;
+
+/* 계층형 타이머 휠.
+   레벨마다 WHEEL_SLOTS개의 슬롯이 있고, 레벨 L의 슬롯 하나는
+   WHEEL_SLOTS^L 틱을 덮는다. 가까운 타이머는 레벨 0에 틱 단위로,
+   먼 타이머는 위 레벨에 넣어 두었다가 아래 레벨 슬롯이 한 바퀴 돌 때마다
+   한 슬롯씩 아래로 내린다(cascade). 삽입은 O(1)이고 틱마다의 처리는
+   만료된 타이머와 내려오는 타이머 수에 비례한다. */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+/* 맨 위 레벨이 덮는 범위. 더 먼 타이머는 이 범위 끝 슬롯에 두었다가
+   내려올 때 다시 배치한다. */
+#define WHEEL_MAX_DELTA ((1LL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+static struct list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static int64_t wheel_next;      /* 다음에 처리할 틱 */
+static size_t wheel_pending;    /* 휠에 걸린 타이머 수 */
+
+static void wheel_insert (struct timer *);
+static void wheel_run (int64_t now);
+static int64_t wheel_next_event (void);
+static void pit_program (uint8_t mode, uint16_t count);
+
 /* 한 틱당 반복할 루프 횟수.
    timer_calibrate()에서 초기화된다. */
 static unsigned loops_per_tick;
 
+/* TSC 클럭소스.
+   timer_calibrate()에서 PIT 틱을 기준으로 TSC 주파수를 잰 뒤,
+   TSC 값 차이를 32.32 고정소수점 곱셈 한 번으로 나노초로 바꾼다.
+   tsc_mult가 0이면 아직 보정 전이라 틱 단위로만 센다. */
+#define NS_PER_SEC 1000000000ULL
+#define NS_PER_TICK (NS_PER_SEC / TIMER_FREQ)
+/* TSC 주파수를 잴 때 기다리는 틱 수 */
+#define TSC_CALIBRATE_TICKS 10
+
+static uint64_t tsc_base;       /* ticks == tsc_base_ticks였을 때의 TSC */
+static int64_t tsc_base_ticks;
+static uint64_t tsc_mult;       /* (NS_PER_SEC << 32) / TSC 주파수 */
+static uint64_t tsc_hz;         /* TSC 주파수 */
+static uint64_t tick_tsc;       /* 마지막 틱 경계의 TSC */
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
@@ -34,12 +87,17 @@ static void real_time_sleep (int64_t num, int32_t denom);
 void
 timer_init (void) {
         /* 8254 입력 주파수를 TIMER_FREQ로 나눠 반올림한 값. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	uint16_t count = PIT_COUNT;
 
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
 
+	for (int level = 0; level < WHEEL_LEVELS; level++)
+		for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+			list_init (&wheel[level][slot]);
+	wheel_next = ticks + 1;
+
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -65,6 +123,37 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	/* 틱 경계에 맞춰 TSC를 읽고, TSC_CALIBRATE_TICKS 틱 뒤에 다시 읽어
+	   TSC 주파수를 구한다. tickless 모드여도 이 동안은 부팅 스레드가
+	   돌고 있으므로 틱이 정상적으로 들어온다. */
+	int64_t start = ticks;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	uint64_t tsc_start = rdtsc ();
+	while (ticks - start < TSC_CALIBRATE_TICKS)
+		barrier ();
+	tsc_hz = (rdtsc () - tsc_start) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+	if (tsc_hz == 0)
+		return;
+
+	tsc_base = tsc_start;
+	tsc_base_ticks = start;
+	tsc_mult = (NS_PER_SEC << 32) / tsc_hz;
+	printf ("TSC clocksource: %'"PRIu64" Hz.\n", tsc_hz);
+}
+
+/* 부팅 이후 지난 시간을 나노초 단위로 반환한다. 단조 증가한다.
+   TSC 보정 전에는 틱 해상도로만 센다. */
+uint64_t
+timer_ns (void) {
+	if (tsc_mult == 0)
+		return (uint64_t) timer_ticks () * NS_PER_TICK;
+
+	uint64_t delta = rdtsc () - tsc_base;
+	return (uint64_t) tsc_base_ticks * NS_PER_TICK
+		+ (uint64_t) (((unsigned __int128) delta * tsc_mult) >> 32);
 }
 
 /*************************************************************
@@ -106,7 +195,7 @@ timer_elapsed (int64_t then) {
  * 
  * 기능:
  * - 현재 tick을 기준으로, 깨어날 tick을 계산하여 thread_sleep() 호출
- * - sleep_list에 현재 스레드를 추가하고 BLOCKED 상태로 전환
+ * - 스레드의 sleep 타이머를 휠에 걸고 BLOCKED 상태로 전환
  * 
  * 반환:
  * - 없음 (void)
@@ -123,7 +212,7 @@ timer_elapsed (int64_t then) {
  * 
  * [TO-BE]
  * - thread_sleep(start + ticks)를 통해 BLOCKED 상태로 진입
- * - thread_awake()가 타이머 인터럽트 시점마다 sleep_list를 확인하고 깨어남
+ * - 타이머 휠이 만료된 sleep 타이머만 골라 스레드를 깨움
  * → 정확하고 효율적인 sleep 가능 (CPU 절약)
  *************************************************************/
 void
@@ -177,33 +266,265 @@ timer_print_stats (void) {
  * 요구사항:
  * - 시스템 틱 수를 증가시켜 전체 시간 흐름을 관리
  * - 현재 실행 중인 스레드의 time slice를 갱신해야 함
- * - sleep_list에 등록된 스레드 중 깨어날 시간이 도래한 경우 깨워야 함
+ * - 만료 시각이 된 커널 타이머(잠든 스레드 포함)를 처리해야 함
  * 
  * 기능:
  * - 전역 변수 ticks를 1 증가시킴
  * - thread_tick()을 호출하여 현재 스레드의 time slice 소모 체크
- * - closest_tick(다음 깨어날 시각)과 비교하여 thread_awake() 호출 여부 결정
+ * - wheel_run()으로 이번 틱에 만료되는 타이머의 함수를 호출
  *
  * 주의:
  * - 인터럽트 컨텍스트에서 실행되므로 thread_block()과 같은 동작은 금지
- * - closest_tick은 sleep_list에 있는 가장 이른 wakeup_tick 값을 나타냄
+ * - 타이머 함수도 인터럽트 컨텍스트에서 실행됨
  * 
  * [AS-IS]
  * - 단순히 ticks 증가 및 thread_tick() 호출만 수행
  * → sleep 상태의 스레드를 깨우는 기능이 없음
  * 
  * [TO-BE]
- * - closest_tick <= ticks일 때만 thread_awake()를 호출하여,
- *   sleep_list에서 깨어날 시각이 지난 스레드를 READY 상태로 전환
- * → 정확하고 효율적인 알람 기능 제공
+ * - 타이머 휠에서 이번 틱 슬롯만 꺼내 만료된 타이머를 처리
+ * → 잠든 스레드 수와 무관하게 틱마다 만료된 것만 처리
  *************************************************************/
 static void
 timer_interrupt (struct intr_frame *args UNUSED) 
 {
+	/* one-shot으로 건너뛴 틱을 따라잡고 주기 모드로 돌아간다.
+	   건너뛴 틱 동안에는 idle만 돌고 있었다. */
+	if (tickless_ticks > 0) {
+		int skipped = tickless_ticks - 1;
+
+		ticks += skipped;
+		thread_account_idle (skipped);
+		tickless_ticks = 0;
+		pit_program (0x34, PIT_COUNT);
+	}
+
+	tick_tsc = rdtsc ();
 	ticks++;						// 전체 시스템 tick 수 증가
 	thread_tick ();					// 현재 running 중인 thread의 tick 처리 및 time slice 만료 검사
-	if (closest_tick() <= ticks)  	// 가장 이른 wakeup_tick(closest_tick)이 현재 tick보다 작거나 같다면
-		thread_awake(ticks);		// → 깨어날 시간이 도래한 스레드가 존재할 수 있으므로 thread_awake() 호출
+	wheel_run (ticks);				// 이번 틱에 만료된 타이머 처리 (잠든 스레드 깨우기 포함)
+}
+
+/* 타이머 T가 만료되면 FUNC(AUX)를 호출하도록 준비한다. */
+void
+timer_setup (struct timer *t, timer_func *func, void *aux) {
+	ASSERT (t != NULL && func != NULL);
+
+	t->func = func;
+	t->aux = aux;
+	t->expires = 0;
+	t->pending = false;
+}
+
+/* 타이머 T를 틱 EXPIRES에 만료되도록 건다. 이미 걸려 있으면 옮긴다.
+   EXPIRES가 이미 지났으면 다음 틱에 만료된다.
+   인터럽트 컨텍스트에서도 호출할 수 있다. */
+void
+timer_add (struct timer *t, int64_t expires) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->pending)
+		list_remove (&t->elem);
+	else
+		wheel_pending++;
+	t->expires = expires;
+	t->pending = true;
+	wheel_insert (t);
+	intr_set_level (old_level);
+}
+
+/* 걸려 있는 타이머 T를 떼어낸다. 떼어냈으면 true, 이미 만료되었거나
+   걸려 있지 않았으면 false. */
+bool
+timer_cancel (struct timer *t) {
+	enum intr_level old_level = intr_disable ();
+	bool pending = t->pending;
+
+	if (pending) {
+		list_remove (&t->elem);
+		t->pending = false;
+		wheel_pending--;
+	}
+	intr_set_level (old_level);
+	return pending;
+}
+
+/* 타이머 T를 만료 시각까지 남은 틱 수에 맞는 레벨의 슬롯에 넣는다.
+   인터럽트가 꺼진 상태에서 호출한다. */
+static void
+wheel_insert (struct timer *t) {
+	int64_t expires = t->expires;
+	int64_t delta = expires - wheel_next;
+	int level;
+
+	if (delta < 0) {
+		/* 이미 지났으면 다음에 처리할 틱의 슬롯에 넣는다. */
+		list_push_back (&wheel[0][wheel_next & WHEEL_MASK], &t->elem);
+		return;
+	}
+	if (delta > WHEEL_MAX_DELTA)
+		expires = wheel_next + WHEEL_MAX_DELTA;
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < (1LL << (WHEEL_BITS * (level + 1))))
+			break;
+	list_push_back (&wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK],
+			&t->elem);
+}
+
+/* LEVEL의 SLOT에 있는 타이머를 모두 꺼내 남은 시간에 맞게 다시 넣는다.
+   SLOT을 돌려주어, 0이면 (한 바퀴를 다 돌았으면) 호출자가 위 레벨도
+   내리도록 한다. */
+static int
+wheel_cascade (int level, int slot) {
+	struct list *list = &wheel[level][slot];
+	struct list moved;
+
+	list_init (&moved);
+	while (!list_empty (list))
+		list_push_back (&moved, list_pop_front (list));
+	while (!list_empty (&moved))
+		wheel_insert (list_entry (list_pop_front (&moved), struct timer, elem));
+	return slot;
+}
+
+/* NOW까지의 틱을 차례로 처리하며 만료된 타이머의 함수를 호출한다.
+   타이머 함수는 다시 timer_add()를 불러 자기 자신을 걸 수 있다. */
+static void
+wheel_run (int64_t now) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (wheel_next <= now) {
+		int slot = wheel_next & WHEEL_MASK;
+		struct list expired;
+		int level;
+
+		if (wheel_pending == 0) {
+			wheel_next = now + 1;
+			break;
+		}
+
+		/* 레벨 0이 한 바퀴 돌면 위 레벨의 다음 슬롯을 내린다. */
+		if (slot == 0)
+			for (level = 1; level < WHEEL_LEVELS; level++)
+				if (wheel_cascade (level,
+						(wheel_next >> (WHEEL_BITS * level)) & WHEEL_MASK) != 0)
+					break;
+
+		list_init (&expired);
+		while (!list_empty (&wheel[0][slot]))
+			list_push_back (&expired, list_pop_front (&wheel[0][slot]));
+		wheel_next++;
+
+		while (!list_empty (&expired)) {
+			struct timer *t = list_entry (list_pop_front (&expired), struct timer, elem);
+
+			t->pending = false;
+			wheel_pending--;
+			t->func (t->aux);
+		}
+	}
+}
+
+/* 휠에서 가장 먼저 처리해야 할 틱. 레벨 0에 걸린 타이머가 있으면 그
+   만료 틱이고, 없으면 레벨 0이 한 바퀴 돌아 위 레벨을 내려야 하는
+   틱이다. 위 레벨의 타이머는 그보다 먼저 만료되지 않는다. */
+static int64_t
+wheel_next_event (void) {
+	int64_t boundary = (wheel_next | WHEEL_MASK) + 1;
+	int64_t t;
+
+	if (wheel_pending == 0)
+		return INT64_MAX;
+	for (t = wheel_next; t < boundary; t++)
+		if (!list_empty (&wheel[0][t & WHEEL_MASK]))
+			return t;
+	return boundary;
+}
+
+/* 8254 카운터 0을 MODE(제어 워드)와 COUNT로 다시 설정한다. */
+static void
+pit_program (uint8_t mode, uint16_t count) {
+	outb (0x43, mode);
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* 8254 카운터 0의 현재 값을 래치해 읽는다. */
+static uint16_t
+pit_read (void) {
+	uint8_t lo, hi;
+
+	outb (0x43, 0x00);
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | (hi << 8);
+}
+
+/* 타이머 인터럽트(IRQ 0)가 PIC에 걸려 처리를 기다리는 중이면 true. */
+static bool
+pit_irq_pending (void) {
+	outb (0x20, 0x0a);    /* OCW3: 다음 읽기에서 IRR을 돌려준다. */
+	return (inb (0x20) & 1) != 0;
+}
+
+/* idle 스레드가 hlt하기 직전, 인터럽트가 꺼진 상태에서 호출한다.
+   다음 타이머 만료까지 틱이 여럿 남았으면 8254를 one-shot 모드로
+   바꾸어 그 틱 경계에서 한 번만 인터럽트가 오게 한다. 현재 틱의 남은
+   카운트부터 이어 세므로 틱 경계의 위상은 그대로다. MLFQS는 틱마다
+   통계를 갱신해야 하므로 켜져 있으면 쓰지 않는다. */
+void
+timer_idle_enter (void) {
+	int64_t n;
+	uint16_t remaining;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || thread_mlfqs || tickless_ticks > 0 || pit_irq_pending ())
+		return;
+
+	n = wheel_next_event () - ticks;
+	if (n <= 1)
+		return;
+	if (n > TICKLESS_MAX)
+		n = TICKLESS_MAX;
+
+	remaining = pit_read ();
+	if (remaining == 0 || remaining > PIT_COUNT)
+		return;
+
+	tickless_ticks = n;
+	tickless_count = remaining + (n - 1) * PIT_COUNT;
+	pit_program (0x30, tickless_count);   /* mode 0: 카운트가 끝나면 한 번 */
+}
+
+/* idle에서 다른 스레드로 전환할 때 인터럽트가 꺼진 상태에서 호출한다.
+   다른 인터럽트 때문에 일찍 깨어났으면 지금까지 지난 틱을 ticks에
+   반영하고, 다음 틱 경계에서 한 번 인터럽트가 오도록 남은 카운트만
+   다시 건다. 그 인터럽트에서 주기 모드로 돌아간다. */
+void
+timer_idle_exit (void) {
+	uint16_t remaining;
+	int elapsed, whole;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (tickless_ticks == 0 || pit_irq_pending ())
+		return;
+
+	remaining = pit_read ();
+	if (remaining > tickless_count)
+		return;     /* 이미 끝까지 셌다. 곧 올 인터럽트가 처리한다. */
+
+	elapsed = tickless_count - remaining;
+	whole = elapsed / PIT_COUNT;
+	ticks += whole;
+	tick_tsc = rdtsc () - (uint64_t) (elapsed % PIT_COUNT) * tsc_hz / PIT_HZ;
+	thread_account_idle (whole);
+
+	tickless_ticks = 1;
+	tickless_count = PIT_COUNT - elapsed % PIT_COUNT;
+	pit_program (0x30, tickless_count);
 }
 
 /* LOOPS번 반복이 한 틱 이상 걸리면 true,
@@ -234,25 +555,39 @@ busy_wait (int64_t loops) {
 		barrier ();
 }
 
-/* NUM/DENOM 초 동안 잠든다. */
+/* NUM/DENOM 초 동안 잠든다.
+   DENOM은 NS_PER_SEC의 약수여야 한다. */
 static void
 real_time_sleep (int64_t num, int32_t denom) {
-        /* NUM/DENOM 초를 타이머 틱으로 환산한 값.
-
-           (NUM / DENOM) s
-           ---------------------- = NUM * TIMER_FREQ / DENOM 틱 */
-	int64_t ticks = num * TIMER_FREQ / denom;
-
 	ASSERT (intr_get_level () == INTR_ON);
-	if (ticks > 0) {
-                /* 한 틱 이상 대기해야 하므로 timer_sleep()을 사용하여
-                   CPU를 다른 스레드에 양보한다. */
-		timer_sleep (ticks);
-	} else {
-                /* 그렇지 않으면 더 정확한 지연을 위해 busy-wait를 사용한다.
-                   오버플로를 피하려고 분자와 분모를 1000으로 줄인다. */
-		ASSERT (denom % 1000 == 0);
-		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+	ASSERT (NS_PER_SEC % denom == 0);
+	if (num <= 0)
+		return;
+
+	if (tsc_mult == 0) {
+		/* TSC 보정 전: 틱 단위로 잠들거나 루프로 기다린다. */
+		int64_t ticks = num * TIMER_FREQ / denom;
+		if (ticks > 0)
+			timer_sleep (ticks);
+		else
+			busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		return;
 	}
-}
 
+	/* 마감 전의 마지막 틱 경계까지는 잠들어 CPU를 양보하고, 그 경계에서
+	   마감까지 남은 한 틱 미만만 TSC를 보며 돈다. 경계 수는 지금이 현재
+	   틱 안에서 얼마나 지났는지(위상)를 더해 세므로, 깨어나는 경계가
+	   마감을 넘지 않는다. 위상을 읽은 뒤 틱이 바뀌지 않도록 인터럽트를
+	   끈 채로 잠든다. */
+	uint64_t sleep_ns = (uint64_t) num * (NS_PER_SEC / denom);
+	uint64_t deadline = timer_ns () + sleep_ns;
+	enum intr_level old_level = intr_disable ();
+	uint64_t phase = (uint64_t) (((unsigned __int128) (rdtsc () - tick_tsc)
+				* tsc_mult) >> 32);
+	int64_t boundaries = (phase + sleep_ns) / NS_PER_TICK;
+	if (boundaries > 0)
+		thread_sleep (ticks + boundaries);
+	intr_set_level (old_level);
+	while (timer_ns () < deadline)
+		barrier ();
+}
@@ -7,6 +7,9 @@
 /* Size of a disk sector in bytes. */
 #define DISK_SECTOR_SIZE 512
 
+/* We support the two "legacy" ATA channels found in a standard PC. */
+#define CHANNEL_CNT 2
+
 /* Index of a disk sector within a disk.
  * Good enough for disks up to 2 TB. */
 typedef uint32_t disk_sector_t;
@@ -1,17 +1,34 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* 만료 시각에 타이머 인터럽트 안에서 호출되는 함수.
+   인터럽트 컨텍스트이므로 잠들 수 없다. */
+typedef void timer_func (void *aux);
+
+/* 커널 타이머. timer_setup()으로 준비하고 timer_add()로 건다.
+   구조체는 호출자가 소유하며, 걸려 있는 동안 해제하면 안 된다. */
+struct timer {
+	int64_t expires;            /* 만료 틱 (timer_ticks() 기준 절대값) */
+	timer_func *func;           /* 만료 시 호출할 함수 */
+	void *aux;                  /* FUNC에 넘길 인자 */
+	bool pending;               /* 휠에 걸려 있는지 */
+	struct list_elem elem;      /* 휠 슬롯 리스트 원소 */
+};
+
 void timer_init (void);
 void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+uint64_t timer_ns (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -20,4 +37,12 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+void timer_setup (struct timer *, timer_func *, void *aux);
+void timer_add (struct timer *, int64_t expires);
+bool timer_cancel (struct timer *);
+
 #endif /* devices/timer.h */
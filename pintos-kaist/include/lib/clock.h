@@ -0,0 +1,16 @@
+#ifndef __LIB_CLOCK_H
+#define __LIB_CLOCK_H
+
+#include <stdint.h>
+
+/* clock_gettime()이 지원하는 시계.
+   CLOCK_MONOTONIC은 부팅 이후 흐른 시간으로, 뒤로 가지 않는다. */
+#define CLOCK_MONOTONIC 1
+
+/* 초와 나노초로 나타낸 시각. 커널과 사용자 프로그램이 함께 쓴다. */
+struct timespec {
+	int64_t tv_sec;             /* 초 */
+	int64_t tv_nsec;            /* 나노초 (0 이상 1e9 미만) */
+};
+
+#endif /* lib/clock.h */
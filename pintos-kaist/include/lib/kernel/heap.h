@@ -0,0 +1,56 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Pairing heap.
+ *
+ * list.h, hash.h와 같은 방식의 침습형(intrusive) 최대 힙입니다.
+ * 힙에 들어갈 구조체는 struct heap_elem 멤버를 포함하고, heap_entry
+ * 매크로로 원래 구조체를 되찾습니다. 동적 할당은 하지 않습니다.
+ *
+ * 삽입, 최댓값 확인은 O(1), 최댓값 꺼내기와 임의 원소 제거는
+ * 분할 상환 O(log n)입니다. 원소의 키가 힙 밖에서 바뀌면(예: 스레드
+ * 우선순위가 donation으로 바뀐 경우) 반드시 heap_update()를 호출해야
+ * 힙 순서가 유지됩니다. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* 첫 번째 자식 */
+	struct heap_elem *next;     /* 오른쪽 형제 */
+	struct heap_elem *prev;     /* 첫 자식이면 부모, 아니면 왼쪽 형제.
+	                               루트이거나 힙 밖이면 NULL */
+};
+
+/* HEAP_ELEM 포인터를 이를 포함한 구조체 포인터로 바꿉니다. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child     \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* A가 B보다 작으면 true를 반환합니다. 가장 "큰" 원소가 루트가 됩니다. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b, void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* 최댓값 원소, 비었으면 NULL */
+	size_t size;                /* 원소 수 */
+	heap_less_func *less;       /* 비교 함수 */
+	void *aux;                  /* 비교 함수에 넘길 추가 데이터 */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+struct heap_elem *heap_top (struct heap *);
+size_t heap_size (struct heap *);
+bool heap_empty (struct heap *);
+bool heap_contains (struct heap *, struct heap_elem *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,20 @@
+#ifndef __LIB_MEMSTAT_H
+#define __LIB_MEMSTAT_H
+
+/* memstat()이 돌려주는 프로세스별 메모리/페이징 통계.
+   커널과 사용자 프로그램이 함께 쓴다. */
+struct memstat {
+	/* 현재 페이지 수 */
+	long long anon_pages;       /* 메모리에 올라와 있는 익명 페이지 */
+	long long file_pages;       /* 메모리에 올라와 있는 파일 매핑 페이지 */
+	long long uninit_pages;     /* 아직 한 번도 접근하지 않은 페이지 */
+	long long swapped_pages;    /* 스왑으로 내보낸 익명 페이지 */
+
+	/* 프로세스가 시작된 뒤 누적된 횟수 */
+	long long minor_faults;     /* 디스크를 읽지 않고 처리한 폴트 */
+	long long major_faults;     /* 파일이나 스왑에서 읽어 온 폴트 */
+	long long fork_copied;      /* fork 때 부모에게서 복사해 온 페이지 */
+	long long writeback_bytes;  /* mmap 해제/종료 때 파일에 다시 쓴 바이트 */
+};
+
+#endif /* lib/memstat.h */
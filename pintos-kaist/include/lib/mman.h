@@ -0,0 +1,8 @@
+#ifndef __LIB_MMAN_H
+#define __LIB_MMAN_H
+
+/* mmap()의 writable 인자에 함께 OR 해서 넘기는 플래그. */
+#define MAP_SHARED 0x2          /* 같은 파일 영역을 매핑한 프로세스끼리
+                                   프레임을 공유한다. */
+
+#endif /* lib/mman.h */
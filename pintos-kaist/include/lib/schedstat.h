@@ -0,0 +1,22 @@
+#ifndef __LIB_SCHEDSTAT_H
+#define __LIB_SCHEDSTAT_H
+
+/* wakeup_hist의 버킷 수. 버킷 K는 [2^K, 2^(K+1)) 나노초 동안 기다린
+   횟수이고, 마지막 버킷은 그보다 긴 대기를 모두 센다. */
+#define SCHEDSTAT_BUCKETS 32
+
+/* schedstat()이 돌려주는 스케줄링 통계. 시간은 나노초 단위.
+   커널과 사용자 프로그램이 함께 쓴다. */
+struct schedstat {
+	/* 호출한 스레드의 누적 값 */
+	long long voluntary_switches;   /* 잠들거나 끝나서 CPU를 내준 횟수 */
+	long long involuntary_switches; /* 선점되거나 yield해서 CPU를 내준 횟수 */
+	long long ready_ns;             /* READY 상태로 기다린 시간 합 */
+	long long ready_max_ns;         /* READY 상태로 한 번에 기다린 최대 시간 */
+	long long run_ns;               /* 실행한 시간 합 */
+
+	/* 시스템 전체: 깨어난(unblock) 뒤 실제로 실행되기까지의 지연 */
+	long long wakeup_hist[SCHEDSTAT_BUCKETS];
+};
+
+#endif /* lib/schedstat.h */
@@ -36,6 +36,15 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_UFFD_CREATE,            /* Create a user fault descriptor. */
+	SYS_UFFD_REGISTER,          /* Register a range for user fault handling. */
+	SYS_UFFD_READ,              /* Wait for a fault on a registered range. */
+	SYS_UFFD_COPY,              /* Fill a faulting page and wake its thread. */
+	SYS_MEMSTAT,                /* Get memory and paging statistics. */
+	SYS_CLOCK_GETTIME,          /* Read a high-resolution clock. */
+	SYS_SCHEDSTAT,              /* Get scheduling statistics. */
 };
 
 #endif /* lib/syscall-nr.h */
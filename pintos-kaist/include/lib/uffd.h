@@ -0,0 +1,13 @@
+#ifndef __LIB_UFFD_H
+#define __LIB_UFFD_H
+
+/* 사용자 공간 페이지 폴트 처리(uffd)에서 커널과 사용자 프로그램이
+   함께 쓰는 정의. */
+
+/* uffd_read()가 돌려주는 페이지 폴트 하나. */
+struct uffd_msg {
+	void *addr;                 /* 폴트가 난 페이지 주소 (페이지 정렬). */
+	int tid;                    /* 폴트를 낸 스레드. */
+};
+
+#endif /* lib/uffd.h */
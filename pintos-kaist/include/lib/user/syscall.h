@@ -4,6 +4,11 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <memstat.h>
+#include <mman.h>
+#include <uffd.h>
+#include <clock.h>
+#include <schedstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -42,6 +47,15 @@ int dup2(int oldfd, int newfd);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
 
+/* Extra for Project 3. */
+int uffd_create (void);
+bool uffd_register (int uffd, void *addr, size_t length);
+bool uffd_read (int uffd, struct uffd_msg *msg);
+bool uffd_copy (int uffd, void *dst, const void *src, size_t length);
+bool memstat (struct memstat *st);
+int clock_gettime (int clock_id, struct timespec *ts);
+bool schedstat (struct schedstat *st);
+
 /* Project 4 only. */
 bool chdir (const char *dir);
 bool mkdir (const char *dir);
@@ -0,0 +1,72 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* MLFQS 계산에 쓰는 17.14 고정소수점 수.
+   커널에서는 부동소수점을 쓸 수 없으므로 int의 하위 14비트를 소수부로
+   쓴다. 곱셈과 나눗셈은 중간 값이 넘치지 않도록 64비트로 계산한다. */
+typedef int fixed_t;
+
+#define FP_SHIFT 14
+#define FP_F (1 << FP_SHIFT)
+
+/* 정수 N을 고정소수점으로 */
+static inline fixed_t
+fp_from_int (int n) {
+	return n * FP_F;
+}
+
+/* X의 소수부를 버린 정수 */
+static inline int
+fp_to_int (fixed_t x) {
+	return x / FP_F;
+}
+
+/* X를 가장 가까운 정수로 반올림 */
+static inline int
+fp_round (fixed_t x) {
+	return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+static inline fixed_t
+fp_add (fixed_t x, fixed_t y) {
+	return x + y;
+}
+
+static inline fixed_t
+fp_sub (fixed_t x, fixed_t y) {
+	return x - y;
+}
+
+static inline fixed_t
+fp_add_int (fixed_t x, int n) {
+	return x + n * FP_F;
+}
+
+static inline fixed_t
+fp_sub_int (fixed_t x, int n) {
+	return x - n * FP_F;
+}
+
+static inline fixed_t
+fp_mul (fixed_t x, fixed_t y) {
+	return (fixed_t) (((int64_t) x) * y / FP_F);
+}
+
+static inline fixed_t
+fp_mul_int (fixed_t x, int n) {
+	return x * n;
+}
+
+static inline fixed_t
+fp_div (fixed_t x, fixed_t y) {
+	return (fixed_t) (((int64_t) x) * FP_F / y);
+}
+
+static inline fixed_t
+fp_div_int (fixed_t x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
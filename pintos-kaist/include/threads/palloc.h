@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+struct bitmap;
+
 /* How to allocate pages. */
 enum palloc_flags {
 	PAL_ASSERT = 001,           /* Panic on failure. */
@@ -17,6 +19,10 @@ extern size_t user_page_limit;
 uint64_t palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_aligned (enum palloc_flags, size_t page_cnt, size_t align_cnt);
+void palloc_user_bounds (void **base, size_t *page_cnt);
+size_t palloc_user_count_used (void *pages, size_t page_cnt);
+size_t palloc_user_claim_free (void *pages, size_t page_cnt, struct bitmap *claimed);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
 
@@ -0,0 +1,27 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+/* switch_threads()가 전환되어 나가는 스레드의 스택에 남기는 프레임.
+   System V 호출 규약에서 호출된 쪽이 보존해야 하는 레지스터만 담는다. */
+struct switch_threads_frame {
+	uint64_t r15;
+	uint64_t r14;
+	uint64_t r13;
+	uint64_t r12;
+	uint64_t rbx;
+	uint64_t rbp;
+	void (*rip) (void);         /* switch_threads()의 복귀 주소 */
+};
+
+/* 현재 스택 포인터를 *CUR_RSP에 저장하고 NEXT_RSP의 스레드로 전환한다. */
+void switch_threads (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* 새 스레드가 처음 전환될 때 돌아오는 곳. rbx에 담긴 intr_frame으로
+   do_iret()을 호출한다. */
+void switch_entry (void);
+#endif
+
+#endif /* threads/switch.h */
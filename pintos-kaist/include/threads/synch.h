@@ -2,12 +2,13 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <heap.h>
 #include <stdbool.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* 대기 스레드 (우선순위 최대 힙) */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -20,6 +21,8 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct heap donors;         /* 이 락을 기다리는 스레드 (우선순위 최대 힙) */
+	struct heap_elem held_elem; /* holder의 held_locks 힙 원소 */
 };
 
 void lock_init (struct lock *);
@@ -28,9 +31,29 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Reader-writer lock.
+   여러 reader가 함께 들어가거나 writer 하나만 들어간다. writer가 오면
+   새 reader는 그 뒤에 줄을 서므로 writer가 굶지 않는다(writer 우선). */
+struct rwlock {
+	struct lock wlock;          /* 쓰는 중이거나 reader가 빠지기를 기다리는 writer가 보유 */
+	unsigned readers;           /* 읽는 중인 스레드 수 */
+	bool writer_waiting;        /* wlock holder가 reader가 빠지기를 기다리는 중 */
+	struct semaphore drained;   /* 마지막 reader가 기다리는 writer를 깨운다 */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+bool rwlock_try_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+bool rwlock_try_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+void rwlock_downgrade (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* 대기자의 semaphore_elem (우선순위 최대 힙) */
 };
 
 void cond_init (struct condition *);
@@ -38,6 +61,9 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+struct thread;
+void synch_requeue (struct thread *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
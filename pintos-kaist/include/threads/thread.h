@@ -6,6 +6,9 @@
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/fixed-point.h"
+#include "devices/timer.h"
+#include <schedstat.h>
 
 /* Thread identifier type.
    You can redefine this to whatever type you like. */
@@ -13,6 +16,7 @@ typedef int tid_t;
 #define TID_ERROR ((tid_t) -1)          /* Error value for tid_t. */
 
 #ifdef VM
+#include <memstat.h>
 #include "kernel/hash.h"
 #endif
 
@@ -29,7 +33,12 @@ enum thread_status {
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
+
+/* MLFQS nice 값의 범위. */
+#define NICE_MIN -20                    /* 가장 양보하지 않음. */
+#define NICE_MAX 20                     /* 가장 많이 양보함. */
 #define FD_MAX 256                      /* FD 테이블 저장 가능한 최대 갯수 */
+#define UFFD_MAX 4                      /* 스레드가 열 수 있는 uffd 최대 갯수 */
 
 /* Supplemental page table structure for managing per-thread pages. */
 #ifdef VM
@@ -101,10 +110,23 @@ struct thread {
 	enum thread_status status;          /* Thread state. */
 	char name[16];                      /* Name (for debugging purposes). */
 	int priority;                       /* Priority. */
-	int64_t wakeup_ticks;				// 일어날 시각 추가
-	struct list donations;              /* 우선순위 donations를 추적하기 위한 리스트 */
+	struct timer sleep_timer;           /* timer_sleep()용 타이머 */
+	struct heap held_locks;             /* 보유한 락. 락마다 가장 높은 대기자 우선순위가 키 */
 	struct lock *wait_on_lock;          /* 대기 중인 락 */
 	int base_priority;                  /* 기부 이전 우선순위 */	
+	int nice;                           /* MLFQS nice 값 */
+	fixed_t recent_cpu;                 /* MLFQS 최근 CPU 사용량 */
+	bool cpu_changed;                   /* 마지막 우선순위 계산 뒤 recent_cpu가 바뀜 */
+
+	/* 스케줄링 통계. 시각은 timer_ns() 기준 나노초 */
+	uint64_t nvcsw;                     /* 자발적 문맥 전환 수 (block, exit) */
+	uint64_t nivcsw;                    /* 비자발적 문맥 전환 수 (선점, yield) */
+	uint64_t ready_since;               /* READY가 된 시각 */
+	uint64_t ready_ns;                  /* READY로 기다린 시간 합 */
+	uint64_t ready_max_ns;              /* READY로 한 번에 기다린 최대 시간 */
+	uint64_t run_since;                 /* 마지막으로 CPU를 받은 시각 */
+	uint64_t run_ns;                    /* 실행한 시간 합 */
+	bool woken;                         /* thread_unblock()으로 READY가 됨 */
 	struct file **fdt;                  /* 파일 디스크립터 테이블 */	
 	int next_fd;                        /* 다음에 배정할 fd */ 
 	int exit_status;	                /* 종료 상태 확인 */
@@ -119,7 +141,14 @@ struct thread {
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* sleep, ready List element. */
-	struct list_elem d_elem;            /* donation List element. */
+	struct heap_elem d_elem;            /* wait_on_lock의 donors 힙 원소 */
+	struct semaphore *wait_on_sema;     /* 대기 중인 세마포어 */
+	struct heap_elem sema_elem;         /* wait_on_sema의 waiters 힙 원소 */
+	uint64_t wait_seq;                  /* 같은 우선순위 대기자 사이의 도착 순서 */
+	struct condition *wait_on_cond;     /* 대기 중인 조건 변수 */
+	struct heap_elem *cond_elem;        /* wait_on_cond의 waiters 힙 원소 (대기자 스택에 있음) */
+	struct list_elem all_elem;          /* 모든 스레드 리스트 원소 */
+	struct list_elem cpu_elem;          /* recent_cpu가 바뀐 스레드 리스트 원소 */
 
 #ifdef USERPROG
 	uint64_t *pml4;                     /* Page map level 4 */
@@ -130,10 +159,14 @@ struct thread {
 	struct supplemental_page_table spt;		
 	
 	uint64_t *stk_rsp;	
+	struct uffd *uffds[UFFD_MAX];       /* uffd 디스크립터 테이블 */
+	struct memstat mstat;               /* 누적 카운터 (페이지 수는 조회 때 센다) */
+	struct exec_profile *exec_prof;     /* 실행 파일의 선적재 프로파일 */
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf;               /* Information for switching */
+	struct intr_frame tf;               /* 첫 실행 때 do_iret()으로 넘길 컨텍스트 */
+	uint64_t switch_rsp;                /* switch_threads()가 저장한 커널 스택 포인터 */
 	struct intr_frame backup_tf;        /* fork 호출 시 유저 스택의 레지스터 값 백업용 */
 	unsigned magic;                     /* 스택 오버플로우를 감지하기 위한 값 (항상 마지막에 배치) */
 };
@@ -144,26 +177,27 @@ struct thread {
 extern bool thread_mlfqs;
 extern void recal_priority(struct thread *t);
 extern void preempt_priority(void);
-extern void donate_priority(struct thread *donur, struct thread *holder);
-extern bool is_in_donations(struct thread *donur, struct thread *holder);
+extern void donate_priority(struct thread *donor);
+extern bool donor_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
 
 
 /* THREADS #1. Alarm Clock */
 void thread_sleep (int64_t ticks);
-void thread_awake (int64_t global_ticks);
-void update_closest_tick (int64_t ticks);
-int64_t closest_tick (void);
-bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux); 
 
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_account_idle (int64_t n);
 void thread_print_stats (void);
+bool thread_schedstat (struct schedstat *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
 
+struct file **fdt_alloc (void);
+void fdt_free (struct file **);
+
 void thread_block (void);
 void thread_unblock (struct thread *);
 
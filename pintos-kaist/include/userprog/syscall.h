@@ -4,6 +4,8 @@
 #include "filesys/file.h"
 #include "vm/file.h"
 #include "vm/vm.h"
+#include "vm/uffd.h"
+#include <clock.h>
 
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
@@ -27,5 +29,6 @@ struct thread *get_child(tid_t tid);
 int get_next_fd(struct thread *curr);
 void *sys_mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void sys_munmap(void *addr);
+int sys_clock_gettime(int clock_id, struct timespec *ts);
 
 #endif /* userprog/syscall.h */
@@ -7,11 +7,24 @@ enum vm_type;
 // ///// 추가 /////
 // struct bitmap swap_table;
 
+/* 스왑 슬롯이 없음을 뜻하는 swap_idx 값 */
+#define SWAP_NONE ((size_t) -1)
+
 struct anon_page {            
-    size_t swap_idx;    
+    size_t swap_idx;            /* 스왑 슬롯 번호. 스왑-인 뒤에도 깨끗한 동안 유지 */
+    void *mmap_base;            /* 익명 mmap 페이지면 매핑 시작 주소, 아니면 NULL */
+    bool patterned;             /* 슬롯 대신 pattern으로 내보낸 페이지인지 */
+    uint64_t pattern;           /* 페이지 전체를 채우는 64비트 값 (0 포함) */
 };
 
+extern const char *swap_option;
+
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void *anon_mmap_base (struct page *page);
+void anon_swap_read (struct page *page, void *kva);
+bool anon_launder (struct page *page);
+void anon_swap_free_pages (struct list *pages);
+unsigned swap_dev_mask (void);
 
 #endif
@@ -6,16 +6,41 @@
 
 struct page;
 enum vm_type;
+struct shared_page;
+
+/* mmap() 호출 하나당 하나씩 만드는 매핑 기술자.
+ * 매핑의 모든 페이지가 이 기술자 하나를 참조하며, 자기 위치는 페이지
+ * 인덱스로 찾습니다. 파일은 매핑 전체에서 한 번만 reopen 합니다. */
+struct mmap_desc {
+	struct file *file;      /* 매핑 전용으로 reopen 한 파일 */
+	void *base;             /* 매핑 시작 주소 */
+	size_t length;          /* 매핑 길이 (페이지 단위로 올림) */
+	off_t ofs;              /* base에 대응하는 파일 오프셋 */
+	size_t read_bytes;      /* base부터 파일에서 읽을 수 있는 바이트 수 */
+	int ref_cnt;            /* 이 기술자를 참조하는 페이지 수 */
+};
 
 struct file_page {
-	struct aux *aux;
+	struct mmap_desc *desc; /* 이 페이지가 속한 매핑 */
+	size_t idx;             /* 매핑 안에서의 페이지 인덱스 */
     bool modified;    
+	struct shared_page *shared;     /* 공유 매핑이면 공유 인덱스 항목 */
+	struct list_elem shared_elem;   /* shared_page의 mappers 리스트 원소 */
+	struct thread *shared_owner;    /* 공유 매핑이면 이 페이지를 매핑한 프로세스 */
 };
 
 void vm_file_init (void);
 bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
+bool lazy_load_mmap (struct page *page, void *aux);
+bool lazy_load_shared (struct page *page, void *aux);
+bool file_shared_test_accessed (struct page *page);
+bool file_shared_is_dirty (struct page *page);
+struct mmap_desc *mmap_desc_get (struct mmap_desc *desc);
+void mmap_desc_put (struct mmap_desc *desc);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+void file_backed_flush (struct list *pages);
+bool file_backed_launder (struct page *page);
 void file_backed_destroy (struct page *page);
 #endif
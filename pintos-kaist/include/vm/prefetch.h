@@ -0,0 +1,13 @@
+#ifndef VM_PREFETCH_H
+#define VM_PREFETCH_H
+#include <stdbool.h>
+
+struct file;
+struct thread;
+
+void prefetch_init (void);
+void prefetch_begin (struct file *file);
+bool prefetch_is_hot (void *upage, bool file_backed);
+void prefetch_record (struct thread *t);
+
+#endif
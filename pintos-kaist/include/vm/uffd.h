@@ -0,0 +1,23 @@
+#ifndef VM_UFFD_H
+#define VM_UFFD_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <uffd.h>
+
+struct thread;
+
+/* uffd 디스크립터 번호의 시작 값. 파일 디스크립터(FD_MAX 미만)와 겹치지
+ * 않도록 따로 떼어 둔다. */
+#define UFFD_FD_BASE 512
+
+void uffd_init (void);
+int uffd_create (void);
+bool uffd_register (int fd, void *addr, size_t length);
+bool uffd_read (int fd, struct uffd_msg *msg);
+bool uffd_copy (int fd, void *dst, const void *src, size_t length);
+bool uffd_close (int fd);
+void uffd_close_all (void);
+void uffd_fork (struct thread *child, struct thread *parent);
+void uffd_release (struct thread *t);
+
+#endif
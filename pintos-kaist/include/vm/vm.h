@@ -40,6 +40,7 @@ enum vm_type {
 
 struct page_operations;
 struct thread;
+struct memstat;
 
 #define VM_TYPE(type) ((type) & 7)
 
@@ -59,6 +60,8 @@ struct page {
 
 	bool is_swaped;
 
+	bool huge_checked;     /* 속한 2MB 구간을 이미 2MB 페이지 후보로 검사함 */
+
 	/* 타입별 데이터가 이 유니온에 결합됩니다.
 	* 각 함수는 현재 어떤 유니온을 써야 할지 자동으로 판별합니다. */
 	union {
@@ -71,14 +74,21 @@ struct page {
 	};
 };
 
-/* frame table 정의 */
+/* frame table 정의. frame_lock이 frame table과 각 frame의 page 연결을
+ * 보호합니다. 교체는 다른 프로세스의 프레임도 고르므로 반드시 필요합니다. */
 extern struct list frame_table;
+extern struct lock frame_lock;
 
 /* "frame" 구조체의 표현 */
 struct frame {
 	void *kva;
 	struct page *page;
+	struct thread *owner;        /* 이 프레임을 매핑한 프로세스 (page의 pml4 소유자) */
+	bool pinned;                 /* 내용을 채우는 중이라 교체 대상에서 제외 */
+	bool in_laundry;             /* 세탁 목록에 올라 있거나 기록 중 */
+	bool laundering;             /* 세탁 스레드나 교체 경로가 지금 내용을 기록하는 중 */
 	struct list_elem frame_elem;
+	struct list_elem laundry_elem;  /* 세탁 목록 원소 */
 };
 
 /* 페이지 동작을 위한 함수 테이블.
@@ -106,6 +116,11 @@ bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
 void vm_init (void);
+struct frame *vm_frame_settle (struct page *page);
+bool vm_migrate_page (struct page *page, void *kva);
+void *vm_compact (void);
+void vm_print_stats (void);
+bool vm_memstat (struct memstat *st);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
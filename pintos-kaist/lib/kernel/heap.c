@@ -0,0 +1,183 @@
+/* Pairing heap.
+
+   각 원소는 자식 리스트의 첫 원소와 형제 포인터만 가지는
+   "왼쪽 자식, 오른쪽 형제" 트리로 표현합니다. 두 힙을 합치는 meld는
+   더 작은 루트를 더 큰 루트의 첫 자식으로 붙이는 것이 전부이고,
+   루트를 뺄 때 남은 자식들을 두 번의 패스(왼쪽에서 오른쪽으로 둘씩 짝지어
+   합친 뒤, 오른쪽에서 왼쪽으로 하나로 합침)로 다시 묶습니다.
+
+   기본적인 정보는 heap.h 파일을 참고하세요. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *, struct heap_elem *,
+		struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+static void detach (struct heap *, struct heap_elem *);
+
+/* LESS로 원소를 비교하는 빈 힙 H를 초기화합니다. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* E를 H에 넣습니다. */
+void
+heap_push (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->next = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+	h->size++;
+}
+
+/* H의 최댓값 원소를 빼서 반환합니다. H는 비어 있으면 안 됩니다. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (!heap_empty (h));
+
+	top = h->root;
+	h->root = merge_pairs (h, top->child);
+	top->child = NULL;
+	h->size--;
+	return top;
+}
+
+/* H에 들어 있는 원소 E를 제거합니다. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	ASSERT (heap_contains (h, e));
+
+	if (e == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	detach (h, e);
+	h->root = meld (h, h->root, merge_pairs (h, e->child));
+	e->child = NULL;
+	h->size--;
+}
+
+/* H에 들어 있는 원소 E의 키가 바뀌었을 때 힙 순서를 복구합니다.
+   키가 커졌든 작아졌든 쓸 수 있습니다. 자식이 없는 원소라면
+   잘라서 루트와 합치는 것만으로 끝납니다. */
+void
+heap_update (struct heap *h, struct heap_elem *e) {
+	struct heap_elem *children;
+
+	ASSERT (heap_contains (h, e));
+
+	if (e == h->root)
+		h->root = NULL;
+	else
+		detach (h, e);
+
+	children = merge_pairs (h, e->child);
+	e->child = NULL;
+	h->root = meld (h, meld (h, h->root, e), children);
+}
+
+/* H의 최댓값 원소를 반환합니다. 비어 있으면 NULL입니다. */
+struct heap_elem *
+heap_top (struct heap *h) {
+	return h->root;
+}
+
+/* H의 원소 수를 반환합니다. */
+size_t
+heap_size (struct heap *h) {
+	return h->size;
+}
+
+/* H가 비어 있으면 true를 반환합니다. */
+bool
+heap_empty (struct heap *h) {
+	return h->root == NULL;
+}
+
+/* E가 H에 들어 있으면 true를 반환합니다.
+   E는 H에 들어 있거나, 어느 힙에도 들어 있지 않아야 합니다. */
+bool
+heap_contains (struct heap *h, struct heap_elem *e) {
+	return e == h->root || e->prev != NULL;
+}
+
+/* 루트 A와 B를 합친 힙의 루트를 반환합니다. 둘 중 하나는 NULL일 수 있습니다. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	if (h->less (a, b, h->aux)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	/* B를 A의 첫 자식으로 붙인다. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+
+	a->next = a->prev = NULL;
+	return a;
+}
+
+/* FIRST부터 이어지는 형제 리스트를 두 번의 패스로 합쳐 하나의 루트를 반환합니다. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* 왼쪽에서 오른쪽으로 둘씩 합치고, 결과를 PAIRS에 거꾸로 쌓는다. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+
+		a = meld (h, a, b);
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* 오른쪽에서 왼쪽으로 하나씩 합친다. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = meld (h, root, pairs);
+		pairs = next;
+	}
+	return root;
+}
+
+/* 루트가 아닌 E를 E의 서브트리째로 부모나 형제에게서 떼어 냅니다. */
+static void
+detach (struct heap *h UNUSED, struct heap_elem *e) {
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+}
@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -194,3 +194,38 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+uffd_create (void) {
+	return syscall0 (SYS_UFFD_CREATE);
+}
+
+bool
+uffd_register (int uffd, void *addr, size_t length) {
+	return syscall3 (SYS_UFFD_REGISTER, uffd, addr, length);
+}
+
+bool
+uffd_read (int uffd, struct uffd_msg *msg) {
+	return syscall2 (SYS_UFFD_READ, uffd, msg);
+}
+
+bool
+uffd_copy (int uffd, void *dst, const void *src, size_t length) {
+	return syscall4 (SYS_UFFD_COPY, uffd, dst, src, length);
+}
+
+bool
+memstat (struct memstat *st) {
+	return syscall1 (SYS_MEMSTAT, st);
+}
+
+int
+clock_gettime (int clock_id, struct timespec *ts) {
+	return syscall2 (SYS_CLOCK_GETTIME, clock_id, ts);
+}
+
+bool
+schedstat (struct schedstat *st) {
+	return syscall1 (SYS_SCHEDSTAT, st);
+}
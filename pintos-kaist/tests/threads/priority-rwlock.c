@@ -0,0 +1,75 @@
+/* The main thread holds a reader-writer lock for reading.  A
+   higher-priority writer then waits for the reader to leave, and
+   an even higher-priority reader queues behind the writer rather
+   than joining the reader already inside, donating its priority
+   to the writer.  When the main thread releases its read lock,
+   the writer and then the reader should run, in that order.
+
+   Also checks the try variants and downgrading a write lock to
+   a read lock. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+static thread_func reader_thread_func;
+
+void
+test_priority_rwlock (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_thread_func, &rw);
+  thread_create ("reader", PRI_DEFAULT + 2, reader_thread_func, &rw);
+  if (rwlock_try_acquire_read (&rw))
+    fail ("read lock granted while a writer was waiting");
+  msg ("Readers queue behind a waiting writer.");
+  rwlock_release_read (&rw);
+  msg ("writer, reader must already have finished, in that order.");
+
+  rwlock_acquire_write (&rw);
+  rwlock_downgrade (&rw);
+  if (!rwlock_try_acquire_read (&rw))
+    fail ("read lock refused after downgrade");
+  if (rwlock_try_acquire_write (&rw))
+    fail ("write lock granted while readers were inside");
+  rwlock_release_read (&rw);
+  rwlock_release_read (&rw);
+  if (!rwlock_try_acquire_write (&rw))
+    fail ("write lock refused after all readers left");
+  rwlock_release_write (&rw);
+  msg ("Downgrade and try variants work.");
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_write (rw);
+  msg ("writer: got the lock, priority %d", thread_get_priority ());
+  rwlock_release_write (rw);
+  msg ("writer: done");
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_read (rw);
+  msg ("reader: got the lock");
+  rwlock_release_read (rw);
+  msg ("reader: done");
+}
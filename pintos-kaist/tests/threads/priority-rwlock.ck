@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-rwlock) begin
+(priority-rwlock) Readers queue behind a waiting writer.
+(priority-rwlock) writer: got the lock, priority 33
+(priority-rwlock) reader: got the lock
+(priority-rwlock) reader: done
+(priority-rwlock) writer: done
+(priority-rwlock) writer, reader must already have finished, in that order.
+(priority-rwlock) Downgrade and try variants work.
+(priority-rwlock) end
+EOF
+pass;
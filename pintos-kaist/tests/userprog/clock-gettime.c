@@ -0,0 +1,33 @@
+/* Reads CLOCK_MONOTONIC repeatedly and checks that it never goes
+   backward and that nanoseconds stay in range.  Also checks that an
+   unknown clock is rejected. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define READS 1000
+
+void
+test_main (void)
+{
+  struct timespec prev, cur;
+  int i;
+
+  CHECK (clock_gettime (CLOCK_MONOTONIC, &prev) == 0,
+         "clock_gettime (CLOCK_MONOTONIC)");
+  for (i = 0; i < READS; i++)
+    {
+      if (clock_gettime (CLOCK_MONOTONIC, &cur) != 0)
+        fail ("clock_gettime failed on read %d", i);
+      if (cur.tv_nsec < 0 || cur.tv_nsec >= 1000000000)
+        fail ("tv_nsec out of range: %lld", (long long) cur.tv_nsec);
+      if (cur.tv_sec < prev.tv_sec
+          || (cur.tv_sec == prev.tv_sec && cur.tv_nsec < prev.tv_nsec))
+        fail ("clock went backward on read %d", i);
+      prev = cur;
+    }
+  msg ("%d reads monotonic", READS);
+
+  CHECK (clock_gettime (-1, &cur) == -1, "clock_gettime (-1) fails");
+}
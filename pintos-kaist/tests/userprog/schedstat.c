@@ -0,0 +1,41 @@
+/* Checks that schedstat() counts a voluntary context switch when
+   the process blocks waiting for a child, and that the wakeup
+   latency histogram records at least one wakeup. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static long long
+wakeups (const struct schedstat *st)
+{
+  long long sum = 0;
+  int k;
+
+  for (k = 0; k < SCHEDSTAT_BUCKETS; k++)
+    sum += st->wakeup_hist[k];
+  return sum;
+}
+
+void
+test_main (void)
+{
+  struct schedstat before, after;
+  pid_t pid;
+
+  CHECK (schedstat (&before), "schedstat before wait");
+  if ((pid = fork ("child-simple")) == 0)
+    exec ("child-simple");
+  CHECK (wait (pid) == 81, "wait for child");
+  CHECK (schedstat (&after), "schedstat after wait");
+
+  if (after.voluntary_switches <= before.voluntary_switches)
+    fail ("waiting for a child did not count a voluntary switch");
+  if (wakeups (&after) <= wakeups (&before))
+    fail ("no wakeup recorded in the latency histogram");
+  if (after.run_ns <= 0)
+    fail ("run time not accounted");
+  if (after.ready_max_ns > after.ready_ns)
+    fail ("max ready time %lld exceeds total %lld",
+          after.ready_max_ns, after.ready_ns);
+}
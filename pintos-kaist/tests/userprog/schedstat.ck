@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(schedstat) begin
+(schedstat) schedstat before wait
+(child-simple) run
+child-simple: exit(81)
+(schedstat) wait for child
+(schedstat) schedstat after wait
+(schedstat) end
+schedstat: exit(0)
+EOF
+pass;
@@ -0,0 +1,20 @@
+/* 첫 접근 페이지 폴트의 처리 속도를 잰다.
+   워킹셋의 각 페이지에 한 번씩만 쓰므로 모든 접근이 lazy loading
+   폴트가 되고, 워킹셋이 RAM보다 크면 교체까지 함께 측정된다. */
+
+#include "tests/vm/bench/bench.h"
+
+int
+main (int argc, char *argv[]) {
+	struct bench_snap start, end;
+	size_t pages = bench_pages (argc, argv);
+	size_t i;
+
+	bench_snap (&start);
+	for (i = 0; i < pages; i++)
+		bench_touch (bench_arena, i, true);
+	bench_snap (&end);
+
+	bench_report ("fault", pages, pages, pages * BENCH_PAGE_SIZE, &start, &end);
+	return 0;
+}
@@ -0,0 +1,31 @@
+/* fork 후 자식이 워킹셋 전체에 쓰는 비용을 잰다.
+   측정 구간에는 주소 공간 복사, 자식의 쓰기, 자식 종료와 회수가
+   모두 포함된다. */
+
+#include <syscall.h>
+#include "tests/vm/bench/bench.h"
+
+int
+main (int argc, char *argv[]) {
+	struct bench_snap start, end;
+	size_t pages = bench_pages (argc, argv);
+	size_t i;
+	pid_t child;
+
+	for (i = 0; i < pages; i++)
+		bench_touch (bench_arena, i, true);
+
+	bench_snap (&start);
+	child = fork ("bench-fork");
+	if (child == 0) {
+		for (i = 0; i < pages; i++)
+			bench_touch (bench_arena, i, true);
+		exit (0);
+	}
+	if (child < 0 || wait (child) != 0)
+		return 1;
+	bench_snap (&end);
+
+	bench_report ("fork", pages, pages, pages * BENCH_PAGE_SIZE, &start, &end);
+	return 0;
+}
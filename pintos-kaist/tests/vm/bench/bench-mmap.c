@@ -0,0 +1,48 @@
+/* 파일 매핑의 쓰기/읽기 대역폭을 잰다.
+   쓰기 측정은 munmap의 write-back까지, 읽기 측정은 다시 매핑한
+   파일을 페이지 단위로 끝까지 읽는 데까지를 포함한다. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/bench/bench.h"
+
+#define MAP_ADDR ((void *) 0x10000000)
+
+int
+main (int argc, char *argv[]) {
+	struct bench_snap start, end;
+	size_t pages = bench_pages (argc, argv);
+	size_t length = pages * BENCH_PAGE_SIZE;
+	uint64_t sum = 0;
+	uint64_t *words;
+	size_t i;
+	void *map;
+	int fd;
+
+	if (!create ("bench.dat", length) || (fd = open ("bench.dat")) < 0)
+		return 1;
+
+	bench_snap (&start);
+	map = mmap (MAP_ADDR, length, true, fd, 0);
+	if (map == MAP_FAILED)
+		return 1;
+	for (i = 0; i < pages; i++)
+		memset ((uint8_t *) map + i * BENCH_PAGE_SIZE, i, BENCH_PAGE_SIZE);
+	munmap (map);
+	bench_snap (&end);
+	bench_report ("mmap-write", pages, pages, length, &start, &end);
+
+	bench_snap (&start);
+	map = mmap (MAP_ADDR, length, false, fd, 0);
+	if (map == MAP_FAILED)
+		return 1;
+	words = map;
+	for (i = 0; i < length / sizeof *words; i++)
+		sum += words[i];
+	munmap (map);
+	bench_snap (&end);
+	bench_report ("mmap-read", pages, pages, length, &start, &end);
+
+	close (fd);
+	return sum == 0;
+}
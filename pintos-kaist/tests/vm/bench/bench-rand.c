@@ -0,0 +1,28 @@
+/* 워킹셋 안의 페이지를 무작위로 건드리는 처리량을 잰다.
+   순차 접근과 달리 교체 정책이 지역성에 기대지 못하는 경우를 본다. */
+
+#include <random.h>
+#include "tests/vm/bench/bench.h"
+
+#define TOUCHES_PER_PAGE 4
+
+int
+main (int argc, char *argv[]) {
+	struct bench_snap start, end;
+	size_t pages = bench_pages (argc, argv);
+	size_t touches = pages * TOUCHES_PER_PAGE;
+	size_t i;
+
+	for (i = 0; i < pages; i++)
+		bench_touch (bench_arena, i, true);
+
+	random_init (0x5eed);
+	bench_snap (&start);
+	for (i = 0; i < touches; i++)
+		bench_touch (bench_arena, random_ulong () % pages, i % 2 == 0);
+	bench_snap (&end);
+
+	bench_report ("rand", pages, touches, touches * BENCH_PAGE_SIZE,
+			&start, &end);
+	return 0;
+}
@@ -0,0 +1,28 @@
+/* 워킹셋을 순차적으로 반복해서 건드리는 처리량을 잰다.
+   첫 패스에서 모든 페이지를 올려 둔 뒤, 이후 패스만 측정하므로
+   측정 구간의 폴트는 교체로 인해 다시 발생한 폴트다. */
+
+#include "tests/vm/bench/bench.h"
+
+#define PASSES 4
+
+int
+main (int argc, char *argv[]) {
+	struct bench_snap start, end;
+	size_t pages = bench_pages (argc, argv);
+	size_t i;
+	int pass;
+
+	for (i = 0; i < pages; i++)
+		bench_touch (bench_arena, i, true);
+
+	bench_snap (&start);
+	for (pass = 0; pass < PASSES; pass++)
+		for (i = 0; i < pages; i++)
+			bench_touch (bench_arena, i, pass % 2 == 0);
+	bench_snap (&end);
+
+	bench_report ("seq", pages, pages * PASSES,
+			pages * PASSES * BENCH_PAGE_SIZE, &start, &end);
+	return 0;
+}
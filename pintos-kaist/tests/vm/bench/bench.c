@@ -0,0 +1,83 @@
+#include "tests/vm/bench/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+uint8_t bench_arena[BENCH_ARENA_PAGES * BENCH_PAGE_SIZE]
+	__attribute__ ((aligned (BENCH_PAGE_SIZE)));
+
+/* int 0x45 (vm/vm.c)로 커널 VM 카운터를 읽는다. */
+static long long
+vm_stat (long long which) {
+	long long val;
+	asm volatile ("int $0x45" : "=a" (val) : "d" (which) : "memory");
+	return val;
+}
+
+/* int 0x43 / 0x44 (devices/disk.c)로 디스크 read/write 횟수를 읽는다. */
+static long long
+disk_read_cnt (long long chan, long long dev) {
+	long long cnt;
+	asm volatile ("int $0x43" : "=a" (cnt) : "d" (chan), "c" (dev) : "memory");
+	return cnt;
+}
+
+static long long
+disk_write_cnt (long long chan, long long dev) {
+	long long cnt;
+	asm volatile ("int $0x44" : "=a" (cnt) : "d" (chan), "c" (dev) : "memory");
+	return cnt;
+}
+
+static uint64_t
+rdtsc (void) {
+	uint32_t lo, hi;
+	asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
+/* 명령행의 첫 인자를 워킹셋 페이지 수로 해석한다. */
+size_t
+bench_pages (int argc, char *argv[]) {
+	size_t pages = BENCH_DEFAULT_PAGES;
+
+	if (argc > 1 && atoi (argv[1]) > 0)
+		pages = atoi (argv[1]);
+	if (pages > BENCH_ARENA_PAGES)
+		pages = BENCH_ARENA_PAGES;
+	return pages;
+}
+
+void
+bench_snap (struct bench_snap *s) {
+	long long mask, bit;
+
+	s->ticks = vm_stat (2);
+	s->faults = vm_stat (0);
+	s->evictions = vm_stat (1);
+	s->swap_reads = s->swap_writes = 0;
+
+	/* 설정된 스왑 장치(--swap2-disk의 hd1:0 포함)마다 카운터를 더한다. */
+	mask = vm_stat (3);
+	for (bit = 0; mask >> bit != 0; bit++)
+		if (mask & (1ull << bit)) {
+			s->swap_reads += disk_read_cnt (bit / 2, bit % 2);
+			s->swap_writes += disk_write_cnt (bit / 2, bit % 2);
+		}
+	s->tsc = rdtsc ();
+}
+
+void
+bench_report (const char *name, size_t pages, size_t touches, size_t bytes,
+		const struct bench_snap *start, const struct bench_snap *end) {
+	printf ("BENCH name=%s pages=%zu touches=%zu bytes=%zu cycles=%llu "
+			"ticks=%lld faults=%lld evictions=%lld swap_reads=%lld "
+			"swap_writes=%lld\n",
+			name, pages, touches, bytes,
+			(unsigned long long) (end->tsc - start->tsc),
+			end->ticks - start->ticks,
+			end->faults - start->faults,
+			end->evictions - start->evictions,
+			end->swap_reads - start->swap_reads,
+			end->swap_writes - start->swap_writes);
+}
@@ -0,0 +1,54 @@
+#ifndef TESTS_VM_BENCH_BENCH_H
+#define TESTS_VM_BENCH_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* VM 성능 측정용 공용 도구.
+ *
+ * 각 벤치마크는 워킹셋 크기(페이지 수)를 인자로 받아 측정 구간 전후의
+ * 커널 카운터를 기록한 뒤, 한 줄짜리 결과를 출력한다:
+ *
+ *   BENCH name=<이름> pages=<워킹셋> touches=<접근 수> bytes=<바이트>
+ *         cycles=<TSC> ticks=<타이머 틱> faults=<폴트> evictions=<교체>
+ *         swap_reads=<섹터> swap_writes=<섹터>
+ *
+ * swap_reads/swap_writes는 disk_print_stats()가 출력하는 스왑 디스크들
+ * (기본 hd1:1, --swap2-disk를 주면 hd1:0도)의 섹터 단위 read/write 횟수를
+ * 합한 값이다. */
+
+#define BENCH_PAGE_SIZE 4096
+#define BENCH_ARENA_PAGES 2048          /* 워킹셋 상한 (8 MB) */
+#define BENCH_DEFAULT_PAGES 1024        /* 인자가 없을 때의 워킹셋 (4 MB) */
+
+/* 익명 메모리 벤치마크가 사용하는 BSS 영역. */
+extern uint8_t bench_arena[BENCH_ARENA_PAGES * BENCH_PAGE_SIZE];
+
+/* 측정 시점의 카운터 스냅샷. */
+struct bench_snap {
+	uint64_t tsc;
+	long long ticks;
+	long long faults;
+	long long evictions;
+	long long swap_reads;
+	long long swap_writes;
+};
+
+size_t bench_pages (int argc, char *argv[]);
+void bench_snap (struct bench_snap *);
+void bench_report (const char *name, size_t pages, size_t touches,
+		size_t bytes, const struct bench_snap *start,
+		const struct bench_snap *end);
+
+/* PAGE번째 페이지를 건드린다. WRITE가 참이면 페이지 첫 워드를 갱신한다. */
+static inline void
+bench_touch (uint8_t *base, size_t page, bool write) {
+	volatile uint8_t *p = base + page * BENCH_PAGE_SIZE;
+	if (write)
+		*p = (uint8_t) page;
+	else
+		(void) *p;
+}
+
+#endif /* tests/vm/bench/bench.h */
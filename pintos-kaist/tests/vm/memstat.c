@@ -0,0 +1,48 @@
+/* Checks that memstat() reports the pages a process touches, the
+   faults it takes to do so, and the bytes written back to a file when
+   a dirty mapping is unmapped. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGES 16
+#define ACTUAL ((char *) 0x10000000)
+
+static char buf[PAGES * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct memstat before, after;
+  int handle;
+  size_t i;
+
+  CHECK (memstat (&before), "memstat before touching");
+  for (i = 0; i < PAGES; i++)
+    buf[i * PAGE_SIZE] = 1;
+  CHECK (memstat (&after), "memstat after touching");
+
+  if (after.anon_pages < before.anon_pages + PAGES)
+    fail ("anon_pages grew by %lld, expected at least %d",
+          after.anon_pages - before.anon_pages, PAGES);
+  if (after.minor_faults + after.major_faults
+      <= before.minor_faults + before.major_faults)
+    fail ("touching new pages did not count any faults");
+
+  CHECK (create ("stat.dat", PAGE_SIZE), "create \"stat.dat\"");
+  CHECK ((handle = open ("stat.dat")) > 1, "open \"stat.dat\"");
+  CHECK (mmap (ACTUAL, PAGE_SIZE, 1, handle, 0) != MAP_FAILED, "mmap \"stat.dat\"");
+  memset (ACTUAL, 'x', PAGE_SIZE);
+  CHECK (memstat (&before), "memstat with dirty mapping");
+  if (before.file_pages < 1)
+    fail ("mapped page not counted as a resident file page");
+  munmap (ACTUAL);
+  CHECK (memstat (&after), "memstat after munmap");
+  if (after.writeback_bytes - before.writeback_bytes != PAGE_SIZE)
+    fail ("munmap wrote back %lld bytes, expected %d",
+          after.writeback_bytes - before.writeback_bytes, PAGE_SIZE);
+  close (handle);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(memstat) begin
+(memstat) memstat before touching
+(memstat) memstat after touching
+(memstat) create "stat.dat"
+(memstat) open "stat.dat"
+(memstat) mmap "stat.dat"
+(memstat) memstat with dirty mapping
+(memstat) memstat after munmap
+(memstat) end
+memstat: exit(0)
+EOF
+pass;
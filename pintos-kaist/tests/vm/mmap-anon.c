@@ -0,0 +1,40 @@
+/* Maps anonymous memory with fd -1, checks that it starts out
+   zero-filled and keeps what is written to it, then unmaps it and
+   checks that the same range can be mapped again from scratch. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+#define SIZE (3 * 4096)
+
+static void
+check_filled (const char *map, char c)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (map[i] != c)
+      fail ("byte %zu of mapping is 0x%02x, expected 0x%02x",
+            i, map[i], c);
+}
+
+void
+test_main (void)
+{
+  char *map;
+
+  CHECK ((map = mmap (ACTUAL, SIZE, 1, -1, 0)) != MAP_FAILED,
+         "mmap anonymous memory");
+  check_filled (map, 0);
+  memset (map, 'x', SIZE);
+  check_filled (map, 'x');
+
+  munmap (map);
+  CHECK ((map = mmap (ACTUAL, SIZE, 1, -1, 0)) != MAP_FAILED,
+         "mmap again after munmap");
+  check_filled (map, 0);
+  munmap (map);
+}
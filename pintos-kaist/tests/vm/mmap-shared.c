@@ -0,0 +1,45 @@
+/* Maps the same file twice with MAP_SHARED and checks that a write
+   through one mapping is immediately visible through the other,
+   since both map the same frame, and that the data reaches the file
+   once both mappings are gone. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define MAP1 ((char *) 0x10000000)
+#define MAP2 ((char *) 0x20000000)
+
+void
+test_main (void)
+{
+  static const char text[] = "shared mappings share frames";
+  char buf[sizeof text];
+  int h1, h2;
+
+  CHECK (create ("shared.dat", 4096), "create \"shared.dat\"");
+  CHECK ((h1 = open ("shared.dat")) > 1, "open \"shared.dat\" once");
+  CHECK ((h2 = open ("shared.dat")) > 1, "open \"shared.dat\" twice");
+  CHECK (mmap (MAP1, 4096, 1 | MAP_SHARED, h1, 0) != MAP_FAILED,
+         "mmap first shared mapping");
+  CHECK (mmap (MAP2, 4096, 1 | MAP_SHARED, h2, 0) != MAP_FAILED,
+         "mmap second shared mapping");
+
+  memcpy (MAP1, text, sizeof text);
+  if (memcmp (MAP2, text, sizeof text))
+    fail ("write through first mapping not seen through second");
+  MAP2[0] = 'S';
+  if (MAP1[0] != 'S')
+    fail ("write through second mapping not seen through first");
+
+  munmap (MAP1);
+  munmap (MAP2);
+
+  CHECK (read (h1, buf, sizeof buf) == (int) sizeof buf,
+         "read \"shared.dat\"");
+  if (buf[0] != 'S' || memcmp (buf + 1, text + 1, sizeof text - 1))
+    fail ("file does not hold data written through the mappings");
+  close (h1);
+  close (h2);
+}
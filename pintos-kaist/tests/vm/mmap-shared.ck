@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mmap-shared) begin
+(mmap-shared) create "shared.dat"
+(mmap-shared) open "shared.dat" once
+(mmap-shared) open "shared.dat" twice
+(mmap-shared) mmap first shared mapping
+(mmap-shared) mmap second shared mapping
+(mmap-shared) read "shared.dat"
+(mmap-shared) end
+mmap-shared: exit(0)
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Writes a buffer larger than physical memory so that it is pushed
+   out to swap, then reads it back twice.  Pages that were swapped in
+   and never written again keep their swap slot, so the second read
+   pass must be able to evict them without writing to the swap disk. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (20 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+/* Returns the number of sectors written to the swap disk (hd1:1). */
+static long long
+swap_write_cnt (void)
+{
+  long long cnt;
+  asm volatile ("int $0x44" : "=a" (cnt) : "d" (1), "c" (1) : "memory");
+  return cnt;
+}
+
+static void
+read_pass (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunks[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+}
+
+void
+test_main (void)
+{
+  long long before;
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunks[i * PAGE_SIZE] = (char) i;
+  msg ("wrote %d pages", PAGE_COUNT);
+
+  read_pass ();
+  msg ("first read pass");
+
+  before = swap_write_cnt ();
+  read_pass ();
+  msg ("second read pass");
+
+  /* Without a swap cache every evicted page costs 8 sector writes. */
+  if (swap_write_cnt () - before >= PAGE_COUNT)
+    fail ("clean pages were written back to swap: %lld sectors",
+          swap_write_cnt () - before);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-cache) begin
+(swap-cache) wrote 5120 pages
+(swap-cache) first read pass
+(swap-cache) second read pass
+(swap-cache) end
+EOF
+pass;
@@ -0,0 +1,52 @@
+/* Fills a buffer larger than physical memory with pages that each
+   repeat a single byte, forcing them out to swap, and checks that
+   they come back intact.  Such pages are recorded as a pattern
+   rather than written to a swap slot, so the swap disk should see
+   almost no writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_SIZE (20 * 1024 * 1024)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+/* Returns the number of sectors written to the swap disk (hd1:1). */
+static long long
+swap_write_cnt (void)
+{
+  long long cnt;
+  asm volatile ("int $0x44" : "=a" (cnt) : "d" (1), "c" (1) : "memory");
+  return cnt;
+}
+
+void
+test_main (void)
+{
+  long long before = swap_write_cnt ();
+  size_t i, j;
+
+  /* Every fourth page stays zero; the rest repeat their page number. */
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (i % 4 != 0)
+      memset (big_chunks + i * PAGE_SIZE, (char) i, PAGE_SIZE);
+  msg ("filled %d pages", PAGE_COUNT);
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char c = i % 4 != 0 ? (char) i : 0;
+
+      for (j = 0; j < PAGE_SIZE; j++)
+        if (big_chunks[i * PAGE_SIZE + j] != c)
+          fail ("byte %zu of page %zu is wrong", j, i);
+    }
+  msg ("checked %d pages", PAGE_COUNT);
+
+  if (swap_write_cnt () - before >= PAGE_COUNT)
+    fail ("pattern pages were written to swap: %lld sectors",
+          swap_write_cnt () - before);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-pattern) begin
+(swap-pattern) filled 5120 pages
+(swap-pattern) checked 5120 pages
+(swap-pattern) end
+EOF
+pass;
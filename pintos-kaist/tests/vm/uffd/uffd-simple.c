@@ -0,0 +1,47 @@
+/* Registers a range in a child process and checks that the parent,
+   acting as the fault handler, can fill each faulting page with
+   uffd_copy(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ADDR ((char *) 0x10000000)
+#define PAGE_SIZE 4096
+#define PAGE_CNT 2
+
+static char page[PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct uffd_msg m;
+  pid_t child;
+  int uffd;
+  int i;
+
+  CHECK ((uffd = uffd_create ()) != -1, "create uffd");
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      if (!uffd_register (uffd, ADDR, PAGE_CNT * PAGE_SIZE))
+        fail ("register range");
+      for (i = 0; i < PAGE_CNT; i++)
+        if (ADDR[i * PAGE_SIZE] != 'a' + i
+            || ADDR[i * PAGE_SIZE + PAGE_SIZE - 1] != 'a' + i)
+          fail ("page %d has wrong contents", i);
+      exit (0);
+    }
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      CHECK (uffd_read (uffd, &m), "read fault %d", i);
+      if (m.addr != ADDR + i * PAGE_SIZE)
+        fail ("fault %d at %p, expected %p", i, m.addr, ADDR + i * PAGE_SIZE);
+      memset (page, 'a' + i, PAGE_SIZE);
+      CHECK (uffd_copy (uffd, m.addr, page, PAGE_SIZE), "copy page %d", i);
+    }
+  CHECK (wait (child) == 0, "wait for child");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(uffd-simple) begin
+(uffd-simple) create uffd
+(uffd-simple) read fault 0
+(uffd-simple) copy page 0
+(uffd-simple) read fault 1
+(uffd-simple) copy page 1
+(uffd-simple) wait for child
+(uffd-simple) end
+EOF
+pass;
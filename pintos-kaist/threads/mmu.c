@@ -2,16 +2,75 @@
 #include <stddef.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* 2MB 페이지를 쪼갤 때 쓸 페이지 테이블. pml4_set_huge_page()가 매핑할
+ * 때 미리 할당해 두므로 쪼개기는 메모리 부족으로 실패하지 않는다. 쓰이기
+ * 전까지는 그 페이지 앞부분에 이 구조체를 담아 split_reserves에 걸어 둔다. */
+struct split_reserve {
+	struct split_reserve *next;
+	const uint64_t *pde;            /* 이 테이블로 쪼갤 PDE */
+};
+static struct split_reserve *split_reserves;
+
+/* PDE를 쪼갤 때 쓸 페이지 테이블 PT를 맡겨 둔다. */
+static void
+split_reserve_put (const uint64_t *pde, void *pt) {
+	struct split_reserve *r = pt;
+	enum intr_level old_level = intr_disable ();
+
+	r->pde = pde;
+	r->next = split_reserves;
+	split_reserves = r;
+	intr_set_level (old_level);
+}
+
+/* PDE에 맡겨 둔 페이지 테이블을 꺼내 반환한다. */
+static void *
+split_reserve_take (const uint64_t *pde) {
+	struct split_reserve **rp, *r = NULL;
+	enum intr_level old_level = intr_disable ();
+
+	for (rp = &split_reserves; *rp != NULL; rp = &(*rp)->next)
+		if ((*rp)->pde == pde) {
+			r = *rp;
+			*rp = r->next;
+			break;
+		}
+	intr_set_level (old_level);
+	ASSERT (r != NULL);
+	return r;
+}
+
+/* PS 비트가 켜진 PDE를 같은 물리 페이지들을 가리키는 4KB PTE 512개짜리
+ * 페이지 테이블로 쪼갠다. 쪼갠 뒤에도 각 4KB 페이지의 물리 주소와 권한,
+ * accessed/dirty 비트는 그대로 유지된다. */
+static void
+split_huge_pde (uint64_t *pde, const uint64_t va) {
+	uint64_t *pt = split_reserve_take (pde);
+
+	uint64_t pa = PTE_ADDR (*pde);
+	uint64_t flags = *pde & PTE_FLAGS & ~(uint64_t) PTE_PS;
+	for (unsigned i = 0; i < HUGE_PGCNT; i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+	invlpg (va & ~(HUGE_PGSIZE - 1));
+}
+
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
 	if (pdp) {
+		/* 2MB 페이지는 4KB 단위로 다루기 전에 쪼갠다. */
+		if ((pdp[idx] & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS))
+			split_huge_pde (&pdp[idx], va);
+
 		uint64_t *pte = (uint64_t *) pdp[idx];
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
@@ -85,6 +144,38 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* 가상 주소 VA를 담당하는 PDE의 주소를 PML4에서 찾아 반환한다.
+ * CREATE가 참이면 중간 단계(PDPT, 페이지 디렉터리)를 필요한 만큼 만들고,
+ * 거짓이면 없는 경우 NULL을 반환한다. pml4e_walk()와 달리 PDE 아래의
+ * 페이지 테이블은 만들지 않으며, 2MB 페이지도 쪼개지 않는다. */
+static uint64_t *
+pde_walk (uint64_t *pml4, const uint64_t va, int create) {
+	uint64_t *entry = &pml4[PML4 (va)];
+
+	for (int level = 0; level < 2; level++) {
+		if (!(*entry & PTE_P)) {
+			if (!create)
+				return NULL;
+			uint64_t *new_page = palloc_get_page (PAL_ZERO);
+			if (new_page == NULL)
+				return NULL;
+			*entry = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		uint64_t *table = ptov (PTE_ADDR (*entry));
+		entry = &table[level == 0 ? PDPE (va) : PDX (va)];
+	}
+	return entry;
+}
+
+/* VA가 2MB 페이지로 매핑되어 있으면 그 PDE를, 아니면 NULL을 반환한다. */
+static uint64_t *
+huge_pde_lookup (uint64_t *pml4, const void *va) {
+	uint64_t *pde = pde_walk (pml4, (uint64_t) va, false);
+	if (pde != NULL && (*pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS))
+		return pde;
+	return NULL;
+}
+
 /* 커널 가상 주소만 매핑된 새 pml4를 만든다.
  * 사용자 영역 매핑은 포함하지 않는다.
  * 생성에 실패하면 NULL을 반환한다. */
@@ -117,6 +208,13 @@ static bool
 pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+		/* FUNC는 4KB PTE를 받으므로 2MB 페이지는 먼저 쪼갠다. */
+		if ((pdp[i] & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS)) {
+			uint64_t va = ((uint64_t) pml4_index << PML4SHIFT) |
+				((uint64_t) pdp_index << PDPESHIFT) |
+				((uint64_t) i << PDXSHIFT);
+			split_huge_pde (&pdp[i], va);
+		}
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
 		if (((uint64_t) pte) & PTE_P)
 			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
@@ -166,8 +264,13 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			pt_destroy (PTE_ADDR (pte));
+		if (((uint64_t) pte) & PTE_P) {
+			if (pdp[i] & PTE_PS) {
+				palloc_free_page (split_reserve_take (&pdp[i]));
+				palloc_free_multiple ((void *) PTE_ADDR (pte), HUGE_PGCNT);
+			} else
+				pt_destroy (PTE_ADDR (pte));
+		}
 	}
 	palloc_free_page ((void *) pdp);
 }
@@ -211,6 +314,10 @@ void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	ASSERT (is_user_vaddr (uaddr));
 
+	uint64_t *pde = huge_pde_lookup (pml4, uaddr);
+	if (pde)
+		return ptov (PTE_ADDR (*pde)) + ((uint64_t) uaddr & (HUGE_PGSIZE - 1));
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -239,6 +346,52 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	return pte != NULL;
 }
 
+/* 2MB 정렬된 사용자 가상 주소 UPAGE부터 2MB를, 2MB 정렬된 연속 물리
+ * 페이지 KPAGE에 PS 비트가 켜진 PDE 하나로 매핑한다. KPAGE는 보통
+ * palloc_get_aligned()로 유저 풀에서 얻은 HUGE_PGCNT개의 페이지다.
+ * 해당 구간에 이미 페이지 테이블이나 다른 매핑이 있거나 중간 단계
+ * 테이블, 또는 나중에 쪼갤 때 쓸 페이지 테이블을 할당하지 못하면 false를
+ * 반환한다. 이후 구간 안의 한 페이지를 4KB 단위로 조작하면
+ * (pml4_clear_page() 등) PDE는 미리 할당해 둔 테이블로 쪼개진다. */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT (((uint64_t) upage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT (((uint64_t) kpage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	uint64_t *pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage, 1);
+
+	if (pde == NULL || (*pde & PTE_P)) {
+		palloc_free_page (pt);
+		return false;
+	}
+	split_reserve_put (pde, pt);
+	*pde = vtop (kpage) | PTE_P | PTE_PS | (rw ? PTE_W : 0) | PTE_U;
+	return true;
+}
+
+/* pml4_set_huge_page()로 UPAGE에 만든 2MB 매핑을 지운다. 물리 페이지는
+ * 호출자가 반납한다. 이미 쪼개졌거나 매핑이 없으면 아무 일도 하지 않는다. */
+void
+pml4_clear_huge_page (uint64_t *pml4, void *upage) {
+	ASSERT (((uint64_t) upage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT (is_user_vaddr (upage));
+
+	uint64_t *pde = huge_pde_lookup (pml4, upage);
+
+	if (pde != NULL) {
+		palloc_free_page (split_reserve_take (pde));
+		*pde = 0;
+		if (rcr3 () == vtop (pml4))
+			invlpg ((uint64_t) upage);
+	}
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -264,6 +417,11 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_dirty (uint64_t *pml4, const void *vpage) {
+	/* 2MB 페이지는 구간 전체에 대해 dirty 비트가 하나뿐이다. */
+	uint64_t *pde = huge_pde_lookup (pml4, vpage);
+	if (pde)
+		return (*pde & PTE_D) != 0;
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	return pte != NULL && (*pte & PTE_D) != 0;
 }
@@ -290,6 +448,10 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
  * PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_accessed (uint64_t *pml4, const void *vpage) {
+	uint64_t *pde = huge_pde_lookup (pml4, vpage);
+	if (pde)
+		return (*pde & PTE_A) != 0;
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
 	return pte != NULL && (*pte & PTE_A) != 0;
 }
@@ -293,6 +293,95 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* palloc_get_multiple()과 같지만, 반환하는 주소가 ALIGN_CNT 페이지
+   경계에 정렬된 PAGE_CNT개의 연속된 빈 페이지를 찾는다. ALIGN_CNT는
+   2의 거듭제곱이어야 한다. 커널 가상 주소는 물리 주소에 2MB 정렬된
+   KERN_BASE를 더한 값이므로, 2MB 이하의 정렬은 물리 주소에도 그대로
+   적용된다. 2MB 페이지 매핑에 쓰인다. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt, size_t align_cnt) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t pool_cnt = bitmap_size (pool->used_map);
+	size_t base_no = pg_no (pool->base);
+	size_t page_idx = BITMAP_ERROR;
+	size_t idx;
+	void *pages;
+
+	ASSERT (align_cnt > 0 && (align_cnt & (align_cnt - 1)) == 0);
+
+	lock_acquire (&pool->lock);
+	/* 풀의 시작 주소는 정렬되어 있지 않을 수 있으므로 첫 정렬 지점부터
+	   ALIGN_CNT 간격으로 후보를 검사한다. */
+	for (idx = ROUND_UP (base_no, align_cnt) - base_no;
+			idx + page_cnt <= pool_cnt; idx += align_cnt)
+		if (bitmap_none (pool->used_map, idx, page_cnt)) {
+			bitmap_set_multiple (pool->used_map, idx, page_cnt, true);
+			page_idx = idx;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (page_idx != BITMAP_ERROR)
+		pages = pool->base + PGSIZE * page_idx;
+	else
+		pages = NULL;
+
+	if (pages) {
+		if (flags & PAL_ZERO)
+			memset (pages, 0, PGSIZE * page_cnt);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+
+	return pages;
+}
+
+/* 사용자 풀이 시작하는 커널 가상 주소를 *BASE에, 페이지 수를 *PAGE_CNT에
+   담는다. 메모리 압축(vm_compact())이 연속 구간 후보를 고를 때 쓴다. */
+void
+palloc_user_bounds (void **base, size_t *page_cnt) {
+	*base = user_pool.base;
+	*page_cnt = bitmap_size (user_pool.used_map);
+}
+
+/* 사용자 풀에서 PAGES부터 PAGE_CNT개의 페이지 중 할당된 페이지 수를
+   반환한다. */
+size_t
+palloc_user_count_used (void *pages, size_t page_cnt) {
+	size_t page_idx = pg_no (pages) - pg_no (user_pool.base);
+	size_t cnt;
+
+	ASSERT (page_from_pool (&user_pool, pages));
+	lock_acquire (&user_pool.lock);
+	cnt = bitmap_count (user_pool.used_map, page_idx, page_cnt, true);
+	lock_release (&user_pool.lock);
+	return cnt;
+}
+
+/* 사용자 풀에서 PAGES부터 PAGE_CNT개의 페이지 중 비어 있는 페이지를 모두
+   할당된 것으로 표시해 다른 할당이 끼어들지 못하게 하고, 그렇게 얻은
+   페이지의 위치를 CLAIMED 비트맵에 표시한다. 얻은 페이지 수를 반환한다.
+   얻은 페이지는 palloc_free_page()로 하나씩 반납할 수 있다. */
+size_t
+palloc_user_claim_free (void *pages, size_t page_cnt, struct bitmap *claimed) {
+	size_t page_idx = pg_no (pages) - pg_no (user_pool.base);
+	size_t cnt = 0;
+	size_t i;
+
+	ASSERT (page_from_pool (&user_pool, pages));
+	ASSERT (bitmap_size (claimed) >= page_cnt);
+	lock_acquire (&user_pool.lock);
+	for (i = 0; i < page_cnt; i++)
+		if (!bitmap_test (user_pool.used_map, page_idx + i)) {
+			bitmap_mark (user_pool.used_map, page_idx + i);
+			bitmap_mark (claimed, i);
+			cnt++;
+		}
+	lock_release (&user_pool.lock);
+	return cnt;
+}
+
 /* 빈 페이지 한 장을 얻어 커널 가상 주소를 반환한다.
    PAL_USER가 있으면 사용자 풀에서, 아니면 커널 풀에서 가져온다.
    PAL_ZERO가 지정되면 페이지를 0으로 채운다.
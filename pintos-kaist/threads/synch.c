@@ -31,7 +31,12 @@
    #include <string.h>
    #include "threads/interrupt.h"
    #include "threads/thread.h"   
-   bool cmp_sema_priority(struct list_elem *a, struct list_elem *b, void *aux);
+
+   static heap_less_func sema_waiter_less;
+   static heap_less_func cond_waiter_less;
+
+   /* 대기자에게 나눠 주는 도착 순번. 우선순위가 같으면 먼저 온 쪽을 깨운다. */
+   static uint64_t next_wait_seq;
    
    /* 세마포어 SEMA를 VALUE 값으로 초기화한다.
           세마포어는 음수가 될 수 없는 정수 값과 다음 두 연산으로 구성된다:
@@ -44,7 +49,7 @@
 	   ASSERT (sema != NULL);
    
 	   sema->value = value;
-	   list_init (&sema->waiters);
+	   heap_init (&sema->waiters, sema_waiter_less, NULL);
    }
    
    /* 세마포어를 감소시키는 down(P) 연산.
@@ -62,9 +67,13 @@
    
 	   old_level = intr_disable ();
 	   
-	   /* sema의 값이 0일 때는 실행 중인 스레드를 우선순위대로 sema의 waiters 리스트에 삽입 */
+	   /* sema의 값이 0일 때는 실행 중인 스레드를 sema의 waiters 힙에 넣고 잠든다 */
 	   while (sema->value == 0) {
-		   list_insert_ordered(&sema->waiters, &thread_current ()->elem, cmp_priority, NULL);						
+		   struct thread *curr = thread_current ();
+
+		   curr->wait_on_sema = sema;
+		   curr->wait_seq = next_wait_seq++;
+		   heap_push (&sema->waiters, &curr->sema_elem);
 		   thread_block ();
 	   }
 	   sema->value--;
@@ -108,11 +117,14 @@
 	   ASSERT (sema != NULL);
    
 	   old_level = intr_disable ();
-	   if (!list_empty (&sema->waiters))
+	   if (!heap_empty (&sema->waiters))
 	   {
-		    /* sema의 대기열에서 lock holder가 donation을 받아 우선순위가 바뀌는 경우를 상정하여 재정렬 */
-			list_sort(&sema->waiters, cmp_priority, NULL);
-			thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem));
+		    /* 대기 중 우선순위가 바뀐 스레드는 synch_requeue()가 이미 자리를 고쳐 두었으므로
+			   루트가 곧 가장 높은 우선순위의 대기자다 */
+			struct thread *t = heap_entry (heap_pop (&sema->waiters), struct thread, sema_elem);
+
+			t->wait_on_sema = NULL;
+			thread_unblock (t);
 	   }
 	   
 	   sema->value++;
@@ -176,6 +188,28 @@
    
 	   lock->holder = NULL;
 	   sema_init (&lock->semaphore, 1);
+	   heap_init (&lock->donors, donor_less, NULL);
+	   lock->held_elem.child = lock->held_elem.next = lock->held_elem.prev = NULL;
+   }
+
+   /* 현재 스레드가 LOCK을 얻은 직후의 donation 장부 정리.
+	  donors 힙에서 자신을 빼고, LOCK을 held_locks 힙에 넣는다.
+	  LOCK에 남은 대기자들은 이제 새 holder에게 기부하게 된다. */
+   static void
+   lock_take (struct lock *lock) {
+	   struct thread *curr = thread_current ();
+	   enum intr_level old_level = intr_disable ();
+
+	   if (heap_contains (&lock->donors, &curr->d_elem))
+		   heap_remove (&lock->donors, &curr->d_elem);
+	   lock->holder = curr;
+	   curr->wait_on_lock = NULL;
+
+	   if (!thread_mlfqs) {
+		   heap_push (&curr->held_locks, &lock->held_elem);
+		   recal_priority (curr);
+	   }
+	   intr_set_level (old_level);
    }
    
    /* Acquires LOCK, sleeping until it becomes available if
@@ -192,15 +226,14 @@
 	   ASSERT (!intr_context ());
 	   thread_current()->wait_on_lock = lock;	
 	   
-	   /* holder가 없거나, donur 자신인 경우, holder의 우선순위가 더 높은 경우를 제외하고, donur의 우선순위 donation */
-	   donate_priority(thread_current(), lock->holder); 
+	   /* lock의 donors 힙에 들어가고, holder가 있으면 holder부터 사슬을 따라 우선순위 donation */
+	   donate_priority(thread_current()); 
 	   
 	   /* sema의 value가 0이면 실행중인 thread를 block, 그렇지 않으면 value를 0으로 만들고 종료 */
 	   sema_down (&lock->semaphore);
    
-	   /* lock 획득에 따른 holder, wait_on_lock 갱신 */	
-	   lock->holder = thread_current ();
-	   thread_current()->wait_on_lock = NULL;
+	   /* lock 획득에 따른 holder, wait_on_lock, 힙 갱신 */	
+	   lock_take (lock);
 	   preempt_priority();
    }
    
@@ -219,7 +252,7 @@
    
 	   success = sema_try_down (&lock->semaphore);
 	   if (success)
-		   lock->holder = thread_current ();
+		   lock_take (lock);
 	   return success;
    }
    
@@ -235,20 +268,18 @@
 	   ASSERT (lock != NULL);
 	   ASSERT (lock_held_by_current_thread (lock));
    
-	   /* donations 리스트를 순회하며 작업이 끝난 lock의 대기 thread를 리스트에서 제거 */
-	   for (struct list_elem *e = list_begin (&curr->donations); e != list_end (&curr->donations); e = list_next(e)) 
-	   {
-		   struct thread *donor = list_entry (e, struct thread, d_elem);        
-   
-		   if (donor->wait_on_lock == lock) 
-			   list_remove (e);             
-	   }
+	   /* held_locks 힙에서 lock을 빼서 lock의 대기자들이 주던 donation을 한 번에 거둔다.
+		  대기자들은 lock의 donors 힙에 그대로 남아 다음 holder에게 기부한다. */
+	   enum intr_level old_level = intr_disable ();
+	   if (heap_contains (&curr->held_locks, &lock->held_elem))
+		   heap_remove (&curr->held_locks, &lock->held_elem);
    
 	   /* 우선순위 복원 */
 	   recal_priority (curr);
    
 	   /* 해당 lock 업데이트 */
 	   lock->holder = NULL;
+	   intr_set_level (old_level);
 	   sema_up (&lock->semaphore);
    
 	   preempt_priority();
@@ -263,11 +294,147 @@
    
 	   return lock->holder == thread_current ();
    }
+
+   /* Initializes RW.  rwlock은 wlock 하나와 reader 수로 이루어진다.
+
+	  - writer는 wlock을 잡은 뒤 읽는 중인 reader가 모두 빠질 때까지 기다린다.
+	  - reader는 wlock을 잠깐 잡았다 놓으면서 reader 수를 늘린다.
+
+	  따라서 writer가 wlock을 잡고 있는 동안 새로 오는 reader와 writer는
+	  모두 wlock 앞에서 기다리며(writer 우선), 그동안 이들의 우선순위는
+	  lock_acquire()의 donation을 통해 wlock을 가진 writer에게 기부된다.
+	  읽는 중인 reader는 여럿일 수 있으므로 이들에게는 donation하지 않는다. */
+   void
+   rwlock_init (struct rwlock *rw) {
+	   ASSERT (rw != NULL);
+
+	   lock_init (&rw->wlock);
+	   rw->readers = 0;
+	   rw->writer_waiting = false;
+	   sema_init (&rw->drained, 0);
+   }
+
+   /* RW를 읽기 모드로 얻는다. writer가 쓰는 중이거나 기다리는 중이면 잠든다. */
+   void
+   rwlock_acquire_read (struct rwlock *rw) {
+	   enum intr_level old_level;
+
+	   ASSERT (rw != NULL);
+	   ASSERT (!intr_context ());
+
+	   lock_acquire (&rw->wlock);
+	   old_level = intr_disable ();
+	   rw->readers++;
+	   intr_set_level (old_level);
+	   lock_release (&rw->wlock);
+   }
+
+   /* RW를 기다리지 않고 읽기 모드로 얻어 본다. 성공하면 true */
+   bool
+   rwlock_try_acquire_read (struct rwlock *rw) {
+	   enum intr_level old_level;
+
+	   ASSERT (rw != NULL);
+
+	   if (!lock_try_acquire (&rw->wlock))
+		   return false;
+	   old_level = intr_disable ();
+	   rw->readers++;
+	   intr_set_level (old_level);
+	   lock_release (&rw->wlock);
+	   return true;
+   }
+
+   /* 읽기 모드로 얻은 RW를 놓는다. 마지막 reader면 기다리는 writer를 깨운다. */
+   void
+   rwlock_release_read (struct rwlock *rw) {
+	   enum intr_level old_level;
+
+	   ASSERT (rw != NULL);
+
+	   old_level = intr_disable ();
+	   ASSERT (rw->readers > 0);
+	   if (--rw->readers == 0 && rw->writer_waiting) {
+		   rw->writer_waiting = false;
+		   sema_up (&rw->drained);
+	   }
+	   intr_set_level (old_level);
+   }
+
+   /* RW를 쓰기 모드로 얻는다. wlock을 잡은 뒤 읽는 중인 reader가 모두
+	  빠질 때까지 잠든다. */
+   void
+   rwlock_acquire_write (struct rwlock *rw) {
+	   enum intr_level old_level;
+
+	   ASSERT (rw != NULL);
+	   ASSERT (!intr_context ());
+
+	   lock_acquire (&rw->wlock);
+	   old_level = intr_disable ();
+	   while (rw->readers > 0) {
+		   rw->writer_waiting = true;
+		   sema_down (&rw->drained);
+	   }
+	   intr_set_level (old_level);
+   }
+
+   /* RW를 기다리지 않고 쓰기 모드로 얻어 본다. 성공하면 true */
+   bool
+   rwlock_try_acquire_write (struct rwlock *rw) {
+	   bool success;
+	   enum intr_level old_level;
+
+	   ASSERT (rw != NULL);
+
+	   if (!lock_try_acquire (&rw->wlock))
+		   return false;
+	   old_level = intr_disable ();
+	   success = rw->readers == 0;
+	   intr_set_level (old_level);
+	   if (!success)
+		   lock_release (&rw->wlock);
+	   return success;
+   }
+
+   /* 쓰기 모드로 얻은 RW를 놓는다. */
+   void
+   rwlock_release_write (struct rwlock *rw) {
+	   ASSERT (rwlock_held_by_current_thread (rw));
+
+	   lock_release (&rw->wlock);
+   }
+
+   /* 쓰기 모드로 얻은 RW를 놓지 않고 읽기 모드로 바꾼다.
+	  기다리던 reader는 곧바로 들어올 수 있고, 다른 writer는 이 reader가
+	  rwlock_release_read()를 부를 때까지 기다린다. */
+   void
+   rwlock_downgrade (struct rwlock *rw) {
+	   enum intr_level old_level;
+
+	   ASSERT (rwlock_held_by_current_thread (rw));
+
+	   old_level = intr_disable ();
+	   rw->readers++;
+	   intr_set_level (old_level);
+	   lock_release (&rw->wlock);
+   }
+
+   /* 현재 스레드가 RW를 쓰기 모드로 가지고 있으면 true.
+	  reader는 따로 기록하지 않으므로 읽기 모드는 알 수 없다. */
+   bool
+   rwlock_held_by_current_thread (const struct rwlock *rw) {
+	   ASSERT (rw != NULL);
+
+	   return lock_held_by_current_thread (&rw->wlock);
+   }
    
-   /* One semaphore in a list. */
+   /* One semaphore in a heap. */
    struct semaphore_elem {
-	   struct list_elem elem;              /* List element. */
+	   struct heap_elem elem;              /* Heap element. */
 	   struct semaphore semaphore;         /* This semaphore. */
+	   struct thread *thread;              /* 기다리는 스레드 (키는 이 스레드의 우선순위) */
+	   uint64_t seq;                       /* 도착 순번 */
    };
    
    /* Initializes condition variable COND.  A condition variable
@@ -277,7 +444,7 @@
    cond_init (struct condition *cond) {
 	   ASSERT (cond != NULL);
    
-	   list_init (&cond->waiters);
+	   heap_init (&cond->waiters, cond_waiter_less, NULL);
    }
    
    /* Atomically releases LOCK and waits for COND to be signaled by
@@ -303,6 +470,8 @@
    void
    cond_wait (struct condition *cond, struct lock *lock) {
 	   	struct semaphore_elem waiter;
+	   	struct thread *curr = thread_current ();
+	   	enum intr_level old_level;
    
 	   	ASSERT (cond != NULL);
 	   	ASSERT (lock != NULL);
@@ -310,9 +479,16 @@
 	   	ASSERT (lock_held_by_current_thread (lock));
    
 	   	sema_init (&waiter.semaphore, 0);
+	   	waiter.thread = curr;
 	   
-	 	/* 각 semaphore의 대기열에 있는 스레드간 우선순위를 비교하여 리스트에 삽입 */  
-	   	list_insert_ordered(&cond->waiters, &waiter.elem, cmp_sema_priority, NULL);
+	 	/* 대기자의 키는 스레드 우선순위이므로, 기다리는 동안 우선순위가 바뀌면
+		   synch_requeue()가 cond_elem으로 자리를 고친다 */  
+	   	old_level = intr_disable ();
+	   	waiter.seq = next_wait_seq++;
+	   	heap_push (&cond->waiters, &waiter.elem);
+	   	curr->wait_on_cond = cond;
+	   	curr->cond_elem = &waiter.elem;
+	   	intr_set_level (old_level);
 
 	   	lock_release (lock);
 	   	sema_down (&waiter.semaphore);
@@ -333,12 +509,18 @@
 	   ASSERT (!intr_context ());
 	   ASSERT (lock_held_by_current_thread (lock));
    
-	   if (!list_empty (&cond->waiters))
+	   enum intr_level old_level = intr_disable ();
+	   if (!heap_empty (&cond->waiters))
 	   {
-			/* cond의 대기열에서 lock holder가 donation을 받아 우선순위가 바뀌는 경우를 상정하여 재정렬 */
-			list_sort(&cond->waiters, cmp_sema_priority, NULL);
-			sema_up (&list_entry (list_pop_front (&cond->waiters), struct semaphore_elem, elem)->semaphore);
-	   }		   	  	
+			/* 가장 높은 우선순위의 대기자를 꺼내 그 세마포어를 올린다 */
+			struct semaphore_elem *waiter = heap_entry (heap_pop (&cond->waiters),
+					struct semaphore_elem, elem);
+
+			waiter->thread->wait_on_cond = NULL;
+			waiter->thread->cond_elem = NULL;
+			sema_up (&waiter->semaphore);
+	   }
+	   intr_set_level (old_level);
    }
    
    /* Wakes up all threads, if any, waiting on COND (protected by
@@ -352,27 +534,40 @@
 	   ASSERT (cond != NULL);
 	   ASSERT (lock != NULL);
    
-	   while (!list_empty (&cond->waiters))
+	   while (!heap_empty (&cond->waiters))
 		   cond_signal (cond, lock);
    }
 
-   bool 
-   cmp_sema_priority(struct list_elem *a, struct list_elem *b, void *aux UNUSED)
-   {
-		/* 각 semaphore에 접근 */
-		struct semaphore_elem *sema_a = list_entry(a, struct semaphore_elem, elem);
-    	struct semaphore_elem *sema_b = list_entry(b, struct semaphore_elem, elem);   
+   /* 세마포어 대기 스레드 비교: 우선순위가 높을수록, 같으면 먼저 온 스레드가 크다 */
+   static bool
+   sema_waiter_less (const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+	   const struct thread *ta = heap_entry (a, struct thread, sema_elem);
+	   const struct thread *tb = heap_entry (b, struct thread, sema_elem);
 
-		/* 각 semaphore의 대기열 리스트에 접근 */		
-		struct list *waiters_a = &(sema_a->semaphore.waiters);
-		struct list *waiters_b = &(sema_b->semaphore.waiters);
-   
-	   	/* 각 대기열에 있는 스레드에 접근 */
-		struct thread *root_a = list_entry(list_begin(waiters_a), struct thread, elem);
-	   	struct thread *root_b = list_entry(list_begin(waiters_b), struct thread, elem);
-   
-	   	/* 두 스레드의 우선순위 비교 */
-		return root_a->priority > root_b->priority;
+	   if (ta->priority != tb->priority)
+		   return ta->priority < tb->priority;
+	   return ta->wait_seq > tb->wait_seq;
    }
 
-   
\ No newline at end of file
+   /* 조건 변수 대기자 비교: 기다리는 스레드의 우선순위와 도착 순번으로 정한다 */
+   static bool
+   cond_waiter_less (const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+	   const struct semaphore_elem *wa = heap_entry (a, struct semaphore_elem, elem);
+	   const struct semaphore_elem *wb = heap_entry (b, struct semaphore_elem, elem);
+
+	   if (wa->thread->priority != wb->thread->priority)
+		   return wa->thread->priority < wb->thread->priority;
+	   return wa->seq > wb->seq;
+   }
+
+   /* T의 우선순위가 바뀐 뒤 호출한다. T가 세마포어나 조건 변수를 기다리는 중이면
+	  그 대기 힙에서 T의 자리를 고친다. 인터럽트가 꺼진 상태에서 호출해야 한다. */
+   void
+   synch_requeue (struct thread *t) {
+	   ASSERT (intr_get_level () == INTR_OFF);
+
+	   if (t->wait_on_sema != NULL)
+		   heap_update (&t->wait_on_sema->waiters, &t->sema_elem);
+	   if (t->wait_on_cond != NULL)
+		   heap_update (&t->wait_on_cond->waiters, t->cond_elem);
+   }
@@ -4,6 +4,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include <random.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
@@ -11,6 +12,7 @@
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/switch.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
 #include "intrinsic.h"
@@ -30,14 +32,16 @@
 
 
 //=== [3] Thread Lists & Global State ===//
-static struct list ready_list;         // 스레드 READY 상태 큐
-static struct list sleep_list;         // BLOCKED 상태 큐 (알람 용도)
+static struct list ready_list[PRI_MAX + 1]; // 우선순위별 READY 상태 큐 (각각 FIFO)
+static uint64_t ready_bitmap;          // 비어 있지 않은 READY 큐의 우선순위 비트
+static int ready_cnt;                  // READY 큐에 있는 스레드 수
 static struct list destruction_req;    // 제거 대기 중인 스레드 리스트
+static struct list all_list;           // 살아 있는 모든 스레드 (MLFQS 초당 갱신용)
+static struct list cpu_changed_list;   // 마지막 우선순위 계산 뒤 recent_cpu가 바뀐 스레드
 
 static struct thread *idle_thread;     // idle 상태의 스레드 포인터
 static struct thread *initial_thread;  // main()을 실행하는 최초 스레드 포인터
 
-static int64_t awake_closest_tick;     // 다음으로 깨워야 할 tick = 가장 빠른 wakeup tick 저장
 static unsigned thread_ticks;          // 최근 타임슬라이스 틱 수 = 마지막 yield 이후의 ticks
 
 /* 통계용 틱 카운터 */
@@ -45,11 +49,27 @@ static long long idle_ticks;
 static long long kernel_ticks;		   
 static long long user_ticks;		   
 
+/* 스케줄링 지연 통계 */
+static uint64_t wakeup_hist[SCHEDSTAT_BUCKETS]; // 깨어난 뒤 실행까지 걸린 시간의 log2 히스토그램
+static uint64_t dead_nvcsw, dead_nivcsw;         // 이미 끝난 스레드들의 문맥 전환 수 합
+
+/* 최근에 해제된 페이지를 페이지 할당자를 거치지 않고 바로 다시 쓰기 위한
+   작은 캐시. fork/exec가 몰릴 때 palloc과 페이지 전체 memset을 줄인다.
+   개수를 RECYCLE_MAX로 묶어 두어 잡아 두는 메모리는 많아야 몇 페이지다. */
+#define RECYCLE_MAX 8
+struct recycle_cache {
+	void *pages[RECYCLE_MAX];
+	size_t cnt;
+};
+static struct recycle_cache thread_recycle;  // 스레드 구조체 + 커널 스택 페이지
+static struct recycle_cache fdt_recycle;     // 모든 슬롯이 NULL인 fdt 페이지
+
 /* tid 할당용 락 */
 static struct lock tid_lock;		   // TID 할당용 락
 
 /* 스케줄러 설정 */
 bool thread_mlfqs;					   // MLFQ 스케줄러 사용 여부
+static fixed_t load_avg;			   // 최근 1분간 READY 스레드 수의 이동 평균
 
 
 //=== [4] GDT 초기화용 커널 전용 GDT ===//
@@ -73,17 +93,30 @@ static void idle (void *idle_started_);
 static void init_thread (struct thread *t, const char *name, int priority);
 static tid_t allocate_tid (void);
 
-/* ------------------ Ready/Sleep Queue Compare Functions ------------------ */
-bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux);
-static bool cmp_wakeup_tick (const struct list_elem *a, const struct list_elem *b, void *aux);
+/* ------------------ Ready Queue ------------------ */
+static void ready_push (struct thread *t);
+static void ready_remove (struct thread *t);
+static int ready_max_priority (void);
+
+/* ------------------ MLFQS ------------------ */
+static void mlfqs_tick (struct thread *t);
+static void mlfqs_update_priority (struct thread *t);
+
+/* ------------------ Sleep Queue ------------------ */
+static void thread_wake (void *t_);
 void preempt_priority(void);
 
 
 //=== [6] Global Function Declarations ===//
 void preempt_priority(void);
 void recal_priority(struct thread *t);
-void donate_priority(struct thread *donor, struct thread *holder);
-bool is_in_donations(struct thread *donor, struct thread *holder);
+void donate_priority(struct thread *donor);
+bool donor_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+static bool held_lock_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+static void *recycle_get (struct recycle_cache *);
+static bool recycle_put (struct recycle_cache *, void *page);
+static void thread_page_free (struct thread *t);
+static void sched_account (struct thread *cur, struct thread *next);
 
 /* ------------------ Debug Utilities ------------------ */
 // static void debug_print_thread_lists (void);    // 디버깅용 리스트 출력 함수
@@ -95,7 +128,7 @@ bool is_in_donations(struct thread *donor, struct thread *holder);
  * 기능:
  * - 현재 실행 중인 코드를 하나의 스레드로 변환
  * - GDT(Global Descriptor Table)를 임시 값으로 설정
- * - ready_list, sleep_list, destruction_req 리스트 초기화
+ * - ready_list, destruction_req 리스트 초기화
  * - tid_lock 초기화 및 최초 실행 스레드 설정
  *
  * 주의:
@@ -119,9 +152,13 @@ thread_init (void) {
 
 	/* Init the global thread context */
 	lock_init (&tid_lock);                   // TID 할당을 위한 락 초기화
-	list_init (&ready_list);                 // 준비 상태 스레드 리스트 초기화
-	list_init (&sleep_list);                 // sleep 상태 스레드 리스트 초기화	
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&ready_list[pri]);        // 우선순위별 준비 상태 스레드 리스트 초기화
+	ready_bitmap = 0;
 	list_init (&destruction_req);            // 제거 요청 대기 스레드 리스트 초기화	
+	list_init (&all_list);                   // 모든 스레드 리스트 초기화
+	list_init (&cpu_changed_list);           // recent_cpu 변경 스레드 리스트 초기화
+	load_avg = 0;
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();      // 현재 실행 중인 스레드를 thread 구조체로 변환
@@ -141,7 +178,7 @@ thread_start (void) {
 
 	/* fdt에 메모리 할당 */
 	struct thread *curr = thread_current ();
-	curr->fdt = palloc_get_page (PAL_ZERO);
+	curr->fdt = fdt_alloc ();
 	if (curr->fdt == NULL)
 		PANIC ("Failed to allocate FDT");
 
@@ -168,16 +205,70 @@ thread_tick (void) {
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs)
+		mlfqs_tick (t);
+
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
 }
 
+/* tickless idle 동안 건너뛴 N틱을 idle 시간으로 센다. */
+void
+thread_account_idle (int64_t n) {
+	idle_ticks += n;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
+	uint64_t nvcsw = dead_nvcsw, nivcsw = dead_nivcsw;
+	struct list_elem *e;
+
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 			idle_ticks, kernel_ticks, user_ticks);
+
+	/* 살아 있는 스레드별 통계 */
+	for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, all_elem);
+
+		nvcsw += t->nvcsw;
+		nivcsw += t->nivcsw;
+		printf ("Thread %s (tid %d): %"PRIu64" voluntary, %"PRIu64" involuntary switches, "
+				"ready %"PRIu64" ns (max %"PRIu64" ns), run %"PRIu64" ns\n",
+				t->name, t->tid, t->nvcsw, t->nivcsw,
+				t->ready_ns, t->ready_max_ns, t->run_ns);
+	}
+	printf ("Sched: %"PRIu64" voluntary, %"PRIu64" involuntary context switches\n",
+			nvcsw, nivcsw);
+
+	/* 깨어난 뒤 실행까지의 지연 히스토그램. 빈 버킷은 생략한다. */
+	for (int k = 0; k < SCHEDSTAT_BUCKETS; k++)
+		if (wakeup_hist[k] != 0)
+			printf ("Sched: wakeup latency %s2^%d ns: %"PRIu64"\n",
+					k == SCHEDSTAT_BUCKETS - 1 ? ">= " : "< ", k + (k != SCHEDSTAT_BUCKETS - 1),
+					wakeup_hist[k]);
+}
+
+/* 현재 스레드의 스케줄링 통계와 시스템 전체의 깨어남 지연 히스토그램을 ST에 채운다. */
+bool
+thread_schedstat (struct schedstat *st) {
+	struct thread *curr = thread_current ();
+	struct schedstat stat;
+	enum intr_level old_level = intr_disable ();
+
+	stat.voluntary_switches = curr->nvcsw;
+	stat.involuntary_switches = curr->nivcsw;
+	stat.ready_ns = curr->ready_ns;
+	stat.ready_max_ns = curr->ready_max_ns;
+	stat.run_ns = curr->run_ns + (timer_ns () - curr->run_since);
+	for (int k = 0; k < SCHEDSTAT_BUCKETS; k++)
+		stat.wakeup_hist[k] = wakeup_hist[k];
+	intr_set_level (old_level);
+
+	/* 사용자 버퍼에 쓰다가 폴트가 날 수 있으므로 인터럽트를 켠 뒤에 복사한다. */
+	memcpy (st, &stat, sizeof stat);
+	return true;
 }
 
 /*************************************************************
@@ -204,18 +295,31 @@ thread_create (const char *name, int priority,
 
 	ASSERT (function != NULL);			// 실행할 함수는 NULL일 수 없음
 
-	/* 스레드 구조체 메모리 할당 및 0으로 초기화 */
-	t = palloc_get_page (PAL_ZERO);   	// PAL_ZERO: 할당 후 0으로 초기화
+	/* 스레드 구조체 메모리 할당. init_thread()가 struct thread 부분을 0으로
+	   채우므로 커널 스택 부분까지 지울 필요는 없다. 최근에 죽은 스레드의 페이지를 먼저 쓴다. */
+	t = recycle_get (&thread_recycle);
+	if (t == NULL)
+		t = palloc_get_page (0);
 	if (t == NULL)
 		return TID_ERROR;				// 메모리 할당 실패 시 오류 반환
 
 	/* 스레드 초기화 및 TID 설정 */
 	init_thread (t, name, priority);     // 이름과 우선순위 설정
 
-    t->fdt = palloc_get_page (PAL_ZERO);
+	/* MLFQS에서는 부모의 nice와 recent_cpu를 물려받고 우선순위를 계산한다. */
+	if (thread_mlfqs) {
+		t->nice = thread_current ()->nice;
+		t->recent_cpu = thread_current ()->recent_cpu;
+		mlfqs_update_priority (t);
+	}
+
+    t->fdt = fdt_alloc ();
        if (t->fdt == NULL)
        {
-			palloc_free_page (t);
+			enum intr_level old_level = intr_disable ();
+			list_remove (&t->all_elem);
+			intr_set_level (old_level);
+			thread_page_free (t);
 			return TID_ERROR;
        } 	
 
@@ -230,6 +334,14 @@ thread_create (const char *name, int priority,
 	t->tf.ss = SEL_KDSEG;                   // 스택 세그먼트
 	t->tf.cs = SEL_KCSEG;                   // 코드 세그먼트
 	t->tf.eflags = FLAG_IF;                 // 인터럽트 플래그 설정
+
+	/* 처음 전환될 때 switch_entry로 돌아가 do_iret(&t->tf)로 kernel_thread를 시작하도록
+	   스택 꼭대기에 초기 전환 프레임을 만든다 */
+	struct switch_threads_frame *sf = (struct switch_threads_frame *) ((uint8_t *) t + PGSIZE) - 1;
+	memset (sf, 0, sizeof *sf);
+	sf->rbx = (uint64_t) &t->tf;
+	sf->rip = switch_entry;
+	t->switch_rsp = (uint64_t) sf;
 	
 	list_push_back(&thread_current()->children, &t->child_elem);  // 부모의 자식 리스트에 삽입
 
@@ -247,17 +359,16 @@ thread_create (const char *name, int priority,
 }
 
 /**********************************************************
- * thread_sleep - 현재 실행 중인 스레드를 지정한 틱 수만큼 재움
+ * thread_sleep - 현재 실행 중인 스레드를 지정한 틱까지 재움
  *
  * 기능:
  * - idle_thread는 재우지 않음
- * - 현재 스레드를 sleep_list에 추가하고 BLOCKED 상태로 전환
- * - wakeup_ticks을 현재 시간 + ticks로 설정
- * - (global) awake_closest_tick 갱신
- * - thread_block() 호출로 스케줄러 대상에서 제외
+ * - 스레드의 sleep_timer를 wakeup_tick에 만료되도록 타이머 휠에 걸고
+ *   thread_block() 호출로 스케줄러 대상에서 제외
+ * - 만료되면 타이머 인터럽트 안에서 thread_wake()가 깨움
  *
  * 동기화:
- * - 인터럽트를 비활성화한 상태에서 sleep_list에 접근
+ * - 타이머를 걸고 block하기 전에 깨어나지 않도록 인터럽트를 끈 채 처리
  *
  * 호출:
  * - timer_sleep() 함수에서 호출됨
@@ -265,97 +376,26 @@ thread_create (const char *name, int priority,
 void
 thread_sleep (int64_t wakeup_tick) 
 {
-    struct thread *cur = thread_current(); // 현재 실행중인 스리드 해석
+    struct thread *cur = thread_current(); // 현재 실행중인 스레드
 
-    if (cur == idle_thread) return;       // idle 스리드는 잠을 할 필요 없음
+    if (cur == idle_thread) return;       // idle 스레드는 잠들 필요 없음
 
-    enum intr_level old_level = intr_disable(); // 동기화 복잡화 목적으로 인터럽트 비활성화
+    enum intr_level old_level = intr_disable(); // 타이머 등록과 block 사이의 경쟁 방지
 
-    cur->wakeup_ticks = wakeup_tick; // 지정된 잠을 기간의 종료 tick을 저장
-    update_closest_tick(wakeup_tick); // 가장 보기 가까운 tick 갱신
-    list_insert_ordered(&sleep_list, &cur->elem, cmp_wakeup_tick, NULL); // wakeup_tick 까지 정렬된 순서로 삽입
-    thread_block(); // 현재 스리드를 BLOCKED 상태로 변경 후 스케줄러 대상\uc5d에서 제제
+    timer_add(&cur->sleep_timer, wakeup_tick); // 타이머 휠에 O(1)로 등록
+    thread_block(); // 현재 스레드를 BLOCKED 상태로 변경 후 스케줄러 대상에서 제외
 
     intr_set_level(old_level); // 이전 인터럽트 상태로 복원
 }
 
-
-static bool 
-cmp_wakeup_tick(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) {
-    struct thread *ta = list_entry(a, struct thread, elem);
-    struct thread *tb = list_entry(b, struct thread, elem);
-    return ta->wakeup_ticks < tb->wakeup_ticks;
-}
-
-
-/*************************************************************
- * thread_awake - 슬립 리스트에서 깨울 시간이 지난 스레드들을 깨움
- *
- * 기능:
- * - sleep_list에 있는 스레드 중, current_tick ≤ 현재 tick인 스레드를 READY 상태로 전환
- * - list_remove() 및 thread_unblock()을 통해 스레드 깨움
- * - 남아 있는 스레드들의 current_tick 중 가장 이른 값으로 awake_closest_tick 갱신
- *
- * 동기화:
- * - 인터럽트 컨텍스트에서 실행되므로 별도 락 불필요
- * - list_remove() 시 반복자 갱신에 주의 필요
- *
- * 호출 위치:
- * - timer_interrupt() 내부에서, ticks ≥ awake_closest_tick일 때 호출
- *
- * 제약 조건:
- * - BLOCKED 상태가 아닌 스레드를 깨우면 안 됨 (thread_unblock 제약)
- * - thread_block() 호출 금지 (인터럽트 컨텍스트이므로)
- *
- * 요구사항:
- * - busy-wait 없이 정확한 tick 기반 sleep/wakeup 동작 보장
- * - awake_closest_tick 값을 매 tick마다 갱신하여 불필요한 검사 최소화
- *************************************************************/
-void
-thread_awake (int64_t current_tick)
-{
-    awake_closest_tick = INT64_MAX;  // 슬립 리스트를 순회하며 가장 빠른 wakeup_tick으로 초기화
-
-    struct list_elem *sleeping = list_begin(&sleep_list);  // sleep_list 순회 시작
-
-    while (sleeping != list_end(&sleep_list)) {
-        struct thread *th = list_entry(sleeping, struct thread, elem);  // 요소를 thread 구조체로 변환
-
-        if (current_tick >= th->wakeup_ticks && th->status == THREAD_BLOCKED) {
-            struct list_elem *next = list_remove(sleeping);  // 리스트에서 제거 후 다음 요소 저장
-            thread_unblock(th);  // BLOCKED 상태 → READY 상태로 전환
-            sleeping = next;  // 다음 요소로 이동
-        } else {
-            update_closest_tick(th->wakeup_ticks);  // 남은 thread 중 가장 가까운 wakeup_tick 갱신
-            break;  // 오름차순 정렬이므로 더 이상 확인할 필요 없음
-        }
-    }
-}
-
-/*************************************************************
- * update_closest_tick - 슬립 리스트 내 최소 wakeup_tick을 갱신
- *
- * 기능:
- * - 현재 tick 값이 awake_closest_tick보다 작으면 갱신
- * - 다음 thread_awake() 시점 결정을 위해 사용됨
- *************************************************************/
-void
-update_closest_tick (int64_t ticks) 
+/* sleep_timer 만료 함수. 타이머 인터럽트 안에서 잠든 스레드를 깨운다. */
+static void
+thread_wake (void *t_)
 {
-	// 기존 awake_closest_tick보다 더 빠른 tick이라면 갱신
-	awake_closest_tick = (awake_closest_tick > ticks) ? ticks : awake_closest_tick;
-}
+	struct thread *t = t_;
 
-/*************************************************************
- * closest_tick - 현재 저장된 가장 이른 wakeup tick 반환
- *
- * 기능:
- * - thread_awake() 호출 여부 판단을 위해 사용됨
- *************************************************************/
-int64_t
-closest_tick (void)
-{
-	return awake_closest_tick;
+	if (t->status == THREAD_BLOCKED)
+		thread_unblock (t);
 }
 
 /*************************************************************
@@ -387,13 +427,13 @@ thread_block (void)
  * thread_unblock - BLOCKED 상태의 스레드를 READY 상태로 전환
  *
  * 기능:
- * - BLOCKED 상태의 스레드를 ready_list에 우선순위 순으로 삽입
+ * - BLOCKED 상태의 스레드를 자기 우선순위의 ready_list 끝에 삽입
  * - 스레드의 상태를 THREAD_READY로 변경
  * - 현재 running 중인 스레드를 선점하지는 않음 (스케줄링은 호출자 책임)
  *
  * 구현:
  * - 인터럽트를 비활성화하여 atomic하게 ready_list 수정
- * - cmp_priority 함수 기준으로 우선순위 삽입 (높은 우선순위 먼저)
+ * - 우선순위별 큐에 넣고 비트맵에 표시하므로 O(1)
  * - 함수 종료 시 인터럽트 상태 복원
  *
  * 주의:
@@ -413,9 +453,10 @@ thread_unblock (struct thread *t)
 	// printf("[UNBLOCK] %s inserted into ready_list (priority: %d)\n", t->name, t->priority);
 	// debug_print_thread_lists();
 
-	list_insert_ordered (&ready_list, &t->elem, cmp_priority, NULL);
-						// ready_list에 우선순위 기준 정렬 삽입 (높은 우선순위가 앞쪽)
+	ready_push (t);							// 우선순위별 ready_list 끝에 삽입
 	t->status = THREAD_READY;				// 스레드 상태를 READY로 전환
+	t->ready_since = timer_ns ();			// 깨어난 시각 (지연 측정용)
+	t->woken = true;
 
 	intr_set_level (old_level);				// 인터럽트 상태 복원 → 인터럽트가 켜진 상태에서만 안전하게 선점 우위 판단 가능
 	// preempt_priority();						// 선점 우위 판단 → thread_yield() 가능
@@ -428,7 +469,7 @@ thread_unblock (struct thread *t)
  * - thread_unblock(), priority update 등 스레드가 READY 상태로 전환되는 순간
  *
  * 기능:
- * - 인터럽트 컨텍스트가 아닐 경우, ready_list의 맨 앞 스레드와 현재 스레드의 우선순위를 비교
+ * - 인터럽트 컨텍스트가 아닐 경우, READY 스레드의 최고 우선순위(비트맵)와 현재 스레드의 우선순위를 비교
  * - 우선순위가 더 높은 스레드가 있다면 현재 스레드는 thread_yield()를 호출해 CPU 양보
  *
  * 주의:
@@ -437,11 +478,10 @@ thread_unblock (struct thread *t)
 void
 preempt_priority(void) 
 {
-	if (!intr_context() && !list_empty(&ready_list)) {	// 인터럽트 핸들러 안에서 실행 중이 아니고, 리스트가 비어있지 않은 경우에만 선점 검사 수행
+	if (!intr_context() && ready_bitmap != 0) {		// 인터럽트 핸들러 안에서 실행 중이 아니고, READY 스레드가 있는 경우에만 선점 검사 수행
 		struct thread *cur = thread_current();			// 현재 실행 중인 스레드의 포인터를 가져옴
-        struct thread *front = list_entry(list_front(&ready_list), struct thread, elem);	// 리스트의 맨 앞(우선순위 높은) 스레드를 가져옴
-		
-        if (cur->priority < front->priority) {			// 만약 현재 스레드보다 더 높은 우선순위의 스레드가 리스트에 있다면            
+
+        if (cur->priority < ready_max_priority()) {	// 만약 현재 스레드보다 더 높은 우선순위의 스레드가 READY 상태라면
 			thread_yield();								// 현재 스레드는 자발적으로 CPU를 양보하여 스케줄러가 다른 스레드를 실행하게 함
         }
     }
@@ -502,6 +542,9 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	list_remove (&thread_current ()->all_elem);
+	if (thread_current ()->cpu_changed)
+		list_remove (&thread_current ()->cpu_elem);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -530,34 +573,14 @@ thread_yield (void) {
 	ASSERT (!intr_context ());		// 인터럽트 핸들러 내에서는 호출 불가 (중첩 스케쥴링 방지)
 	old_level = intr_disable ();	// 인터럽트를 비활성화(ready_list 수정 중 동기화 필요)하고 이전 상태를 리턴
 	
-	if (curr != idle_thread)			// 현재 스레드가 idle이 아니라면 ready_list에 우선순위 기준으로 삽입
-		list_insert_ordered (&ready_list, &curr->elem, cmp_priority, NULL);
+	if (curr != idle_thread)			// 현재 스레드가 idle이 아니라면 자기 우선순위의 ready_list 끝에 삽입
+		ready_push (curr);
+	curr->ready_since = timer_ns ();
 	
 	do_schedule (THREAD_READY);		// 현재 스레드 상태를 THREAD_READY로 바꾸고 스케줄링 수행
 	intr_set_level (old_level);		// 인터럽트 상태 복원
 }
 
-/*************************************************************
- * cmp_priority - 스레드 우선순위 비교 함수 (list_insert_ordered 전용)
- *
- * 기능:
- * - 높은 priority 값을 가진 스레드를 우선하도록 비교 (내림차순 정렬)
- * - 우선순위가 같은 경우, wakeup_ticks가 더 작은 스레드를 먼저 배치 (FIFO 보장)
- *
- * 사용 위치:
- * - ready_list 등에서 list_insert_ordered()의 비교 함수로 사용
- *************************************************************/
-bool
-cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED) 
-{
-	struct thread *ta = list_entry(a, struct thread, elem);		// a 요소를 thread 구조체로 변환
-	struct thread *tb = list_entry(b, struct thread, elem);		// b 요소를 thread 구조체로 변환
-
-	if (ta->priority == tb->priority)				 // 우선순위가 같은 경우 (tie-breaker)
-        return ta->wakeup_ticks < tb->wakeup_ticks;  // wakeup_thicks가 빠른 스레드를 우선 배치 (FIFO)
-	return ta->priority > tb->priority;				 // 우선순위가 높은 (값이 큰) 스레드를 먼저 배치
-}
-
 /*************************************************************
  * thread_set_priority - 현재 실행 중인 스레드의 우선순위 변경
  *
@@ -579,6 +602,10 @@ cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNU
 void
 thread_set_priority (int new_priority) 
 {
+	/* MLFQS에서는 스케줄러가 우선순위를 정하므로 무시한다. */
+	if (thread_mlfqs)
+		return;
+
 	/* base_priority를 갱신한다음 우선순위를 재계산하여 동기화 */ 
 	thread_current ()->base_priority = new_priority; 
 	recal_priority(thread_current());
@@ -593,31 +620,137 @@ thread_get_priority (void) {
 	return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE, clamped to
+   [NICE_MIN, NICE_MAX]. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	if (nice < NICE_MIN)
+		nice = NICE_MIN;
+	else if (nice > NICE_MAX)
+		nice = NICE_MAX;
+	thread_current ()->nice = nice;
+
+	/* 우선순위 스케줄러에서는 nice가 우선순위에 영향을 주지 않는다. */
+	if (!thread_mlfqs)
+		return;
+
+	enum intr_level old_level = intr_disable ();
+	mlfqs_update_priority (thread_current ());
+	intr_set_level (old_level);
+
+	/* 우선순위가 낮아졌으면 양보 */
+	preempt_priority ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load = fp_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old_level);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int recent = fp_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+	intr_set_level (old_level);
+	return recent;
+}
+
+/*************************************************************
+ * mlfqs_update_priority - T의 MLFQS 우선순위를 다시 계산
+ *
+ * priority = PRI_MAX - (recent_cpu / 4) - (nice * 2)
+ * 를 PRI_MIN..PRI_MAX로 자른다. T가 READY 상태면 새 우선순위의
+ * 큐로 옮긴다. 인터럽트가 꺼진 상태에서 호출한다.
+ *************************************************************/
+static void
+mlfqs_update_priority (struct thread *t)
+{
+	int priority = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4)) - t->nice * 2;
+
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	if (priority > PRI_MAX)
+		priority = PRI_MAX;
+
+	if (t->priority == priority)
+		return;
+
+	if (t->status == THREAD_READY) {
+		ready_remove (t);
+		t->priority = priority;
+		ready_push (t);
+	} else {
+		t->priority = priority;
+		synch_requeue (t);
+	}
+}
+
+/*************************************************************
+ * mlfqs_tick - 타이머 틱마다 MLFQS 상태를 갱신 (인터럽트 컨텍스트)
+ *
+ * - 실행 중인 스레드(idle 제외)의 recent_cpu를 1 늘리고 변경 목록에 올림
+ * - 1초마다: load_avg를 갱신하고, 감쇠 계수를 한 번만 계산해 모든
+ *   스레드의 recent_cpu와 우선순위를 한꺼번에 다시 계산
+ * - 4틱마다: 그 사이 recent_cpu가 바뀐(실행된) 스레드만 우선순위를
+ *   다시 계산. 나머지 스레드는 입력 값이 그대로라 계산할 필요가 없다.
+ * - 더 높은 우선순위의 READY 스레드가 생기면 인터럽트 복귀 시 양보
+ *************************************************************/
+static void
+mlfqs_tick (struct thread *t)
+{
+	int64_t ticks = timer_ticks ();
+	struct list_elem *e;
+
+	if (t != idle_thread) {
+		t->recent_cpu = fp_add_int (t->recent_cpu, 1);
+		if (!t->cpu_changed) {
+			t->cpu_changed = true;
+			list_push_back (&cpu_changed_list, &t->cpu_elem);
+		}
+	}
+
+	if (ticks % TIMER_FREQ == 0) {
+		int ready_threads = ready_cnt + (t != idle_thread ? 1 : 0);
+		fixed_t decay;
+
+		load_avg = fp_add (fp_mul (fp_div_int (fp_from_int (59), 60), load_avg),
+				fp_div_int (fp_from_int (ready_threads), 60));
+		decay = fp_div (fp_mul_int (load_avg, 2),
+				fp_add_int (fp_mul_int (load_avg, 2), 1));
+
+		for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)) {
+			struct thread *th = list_entry (e, struct thread, all_elem);
+
+			if (th == idle_thread)
+				continue;
+			th->recent_cpu = fp_add_int (fp_mul (decay, th->recent_cpu), th->nice);
+			mlfqs_update_priority (th);
+		}
+		while (!list_empty (&cpu_changed_list))
+			list_entry (list_pop_front (&cpu_changed_list),
+					struct thread, cpu_elem)->cpu_changed = false;
+	} else if (ticks % 4 == 0) {
+		while (!list_empty (&cpu_changed_list)) {
+			struct thread *th = list_entry (list_pop_front (&cpu_changed_list),
+					struct thread, cpu_elem);
+			th->cpu_changed = false;
+			mlfqs_update_priority (th);
+		}
+	}
+
+	if (ready_bitmap != 0 && t->priority < ready_max_priority ())
+		intr_yield_on_return ();
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -641,6 +774,9 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+		/* 깨울 일이 없으면 다음 타이머 만료까지 주기 인터럽트를 멈춘다. */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -677,7 +813,7 @@ init_thread (struct thread *t, const char *name, int priority) {
 
 	memset (t, 0, sizeof *t);
 	t->status = THREAD_BLOCKED;
-	t->wakeup_ticks = 0;
+	timer_setup (&t->sleep_timer, thread_wake, t);
 	strlcpy (t->name, name, sizeof t->name);
 	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
 	t->priority = priority;
@@ -692,7 +828,16 @@ init_thread (struct thread *t, const char *name, int priority) {
 	sema_init(&t->load_sema, 0); /* load_sema 초기화 */
 	
 	list_init(&t->children);  /* 자식 리스트 초기화 */	
-	list_init(&t->donations); /* donation 리스트 초기화 */	
+	heap_init(&t->held_locks, held_lock_less, NULL); /* 보유 락 힙 초기화 */
+
+	/* MLFQS 필드. 최초 스레드는 nice와 recent_cpu가 0에서 시작한다. */
+	t->nice = 0;
+	t->recent_cpu = 0;
+	t->cpu_changed = false;
+
+	enum intr_level old_level = intr_disable ();
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
@@ -702,10 +847,44 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	struct thread *next;
+
+	if (ready_bitmap == 0)
 		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+
+	next = list_entry (list_front (&ready_list[ready_max_priority ()]),
+			struct thread, elem);
+	ready_remove (next);
+	return next;
+}
+
+/* T를 자기 우선순위의 READY 큐 끝에 넣고 비트맵에 표시한다.
+   인터럽트가 꺼진 상태에서 호출한다. */
+static void
+ready_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	list_push_back (&ready_list[t->priority], &t->elem);
+	ready_bitmap |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/* READY 큐에서 T를 빼고, 큐가 비면 비트맵에서 지운다. T의 priority는
+   넣을 때의 값이어야 한다. 인터럽트가 꺼진 상태에서 호출한다. */
+static void
+ready_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	list_remove (&t->elem);
+	if (list_empty (&ready_list[t->priority]))
+		ready_bitmap &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* READY 스레드 중 가장 높은 우선순위. 비트맵의 최상위 비트 하나만
+   찾으면 된다 (bsr). READY 스레드가 있을 때만 호출한다. */
+static int
+ready_max_priority (void) {
+	ASSERT (ready_bitmap != 0);
+	return 63 - __builtin_clzll (ready_bitmap);
 }
 
 /* Use iretq to launch the thread */
@@ -736,71 +915,61 @@ do_iret (struct intr_frame *tf) {
 			: : "g" ((uint64_t) tf) : "memory");
 }
 
-/* 새 스레드의 페이지 테이블을 활성화하여 스레드를 전환한다.
-   이전 스레드가 종료 상태이면 이곳에서 파괴한다.
+/* K = floor(log2(NS))인 히스토그램 버킷. 마지막 버킷은 그 이상을 모두 센다. */
+static int
+latency_bucket (uint64_t ns) {
+	int k = ns != 0 ? 63 - __builtin_clzll (ns) : 0;
 
-   이 함수가 호출될 때는 이미 PREV 스레드에서 전환된 뒤이며
-   새 스레드가 실행 중이고 인터럽트는 아직 꺼져 있다.
+	return k < SCHEDSTAT_BUCKETS ? k : SCHEDSTAT_BUCKETS - 1;
+}
 
-   스레드 전환이 끝나기 전에는 printf() 사용이 안전하지 않다.
-   실제로는 함수 끝부분에서만 printf()를 호출해야 한다. */
+/* CUR에서 NEXT로 전환하기 직전에 스케줄링 통계를 갱신한다.
+   CUR이 READY면 선점/yield(비자발적), 아니면 block/exit(자발적) 전환이다.
+   NEXT가 READY로 기다린 시간을 더하고, unblock으로 깨어난 경우에는
+   그 시간을 지연 히스토그램에도 넣는다. 인터럽트가 꺼진 상태에서 호출한다. */
+static void
+sched_account (struct thread *cur, struct thread *next) {
+	uint64_t now = timer_ns ();
+
+	cur->run_ns += now - cur->run_since;
+	if (cur->status == THREAD_READY)
+		cur->nivcsw++;
+	else
+		cur->nvcsw++;
+	if (cur->status == THREAD_DYING) {
+		dead_nvcsw += cur->nvcsw;
+		dead_nivcsw += cur->nivcsw;
+	}
+
+	/* idle 스레드는 READY 큐를 거치지 않으므로 대기 시간이 없다. */
+	if (next != idle_thread) {
+		uint64_t wait = now - next->ready_since;
+
+		next->ready_ns += wait;
+		if (wait > next->ready_max_ns)
+			next->ready_max_ns = wait;
+		if (next->woken)
+			wakeup_hist[latency_bucket (wait)]++;
+	}
+	next->woken = false;
+	next->run_since = now;
+}
+
+/* 현재 스레드에서 TH로 문맥을 전환한다. 인터럽트는 꺼져 있어야 한다.
+
+   schedule()을 통한 전환은 모두 함수 호출 안에서 일어나므로 호출 규약상
+   callee-saved 레지스터와 rsp, rip만 보존하면 된다. 나머지 레지스터는
+   호출한 쪽이 이미 저장했거나 버려도 되는 값이고, 세그먼트 레지스터는
+   커널 안에서 바뀌지 않으며, IF는 양쪽 모두 꺼져 있다.
+   intr_frame 전체를 채워 iretq로 복귀하는 경로(do_iret)는 새 스레드의
+   첫 실행(switch_entry)과 사용자 모드 복귀에만 쓴다.
+
+   전환이 끝나기 전에는 printf() 사용이 안전하지 않다. */
 static void
 thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
 	ASSERT (intr_get_level () == INTR_OFF);
 
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
+	switch_threads (&running_thread ()->switch_rsp, th->switch_rsp);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -814,7 +983,10 @@ do_schedule(int status) {
 	while (!list_empty (&destruction_req)) { 
 		struct thread *victim = // 교체될 스레드
 			list_entry (list_pop_front (&destruction_req), struct thread, elem); 
-		palloc_free_page(victim); // 교체될 스레드 메모리 해제
+		/* USERPROG가 아니면 process_exit()이 없으므로 쓰지 않은 fdt를 여기서 돌려받는다 */
+		if (victim->fdt != NULL)
+			fdt_free (victim->fdt);
+		thread_page_free (victim); // 교체될 스레드 메모리 해제
 	}
 	thread_current ()->status = status; 
 	schedule (); // 문맥 전환
@@ -846,6 +1018,9 @@ schedule (void)
 	ASSERT (cur->status != THREAD_RUNNING);        // 현재 스레드는 더 이상 RUNNING 상태가 아니어야 함
 	ASSERT (is_thread (next));                      // next가 유효한 스레드인지 확인
 
+	if (cur == idle_thread && next != idle_thread)
+		timer_idle_exit ();                         // tickless idle이었다면 지난 틱을 따라잡음
+
 	next->status = THREAD_RUNNING;                  // 다음 스레드를 RUNNING 상태로 전환
 	thread_ticks = 0;                               // 새 타임 슬라이스 시작
 
@@ -853,6 +1028,8 @@ schedule (void)
 	process_activate (next);                        // 사용자 프로그램이면 주소 공간 교체
 #endif
 	if (cur != next) {
+		sched_account (cur, next);                  // 실행/대기 시간과 문맥 전환 수 기록
+
 		// 현재 스레드가 죽은 상태라면, 나중에 메모리 해제를 위해 큐에 넣음
 		if (cur && cur->status == THREAD_DYING && cur != initial_thread) {
 			ASSERT (cur != next);                  // dying 스레드는 당연히 next가 될 수 없음
@@ -876,84 +1053,155 @@ allocate_tid (void)
 	return tid;
 }
 
-void recal_priority(struct thread *t)
+/* LOCK을 기다리는 스레드 중 가장 높은 우선순위. 대기자가 없으면 PRI_MIN - 1 */
+static int lock_donor_priority(struct lock *lock)
 {
-	int max_p = t->base_priority; /* base_priority로 초기화 */
-
-	/* 해당 thread의 donations list에 있는 thread들을 순회하며 가장 큰 priority를 탐색 */
-	for(struct list_elem *e = list_begin(&t->donations); e != list_end(&t->donations); e = list_next(e))
-	{
-		struct thread *cmp_t = list_entry(e, struct thread, d_elem);
-		max_p = max_p > cmp_t->priority ? max_p : cmp_t->priority;
-	}
+	if (heap_empty(&lock->donors))
+		return PRI_MIN - 1;
+	return heap_entry(heap_top(&lock->donors), struct thread, d_elem)->priority;
+}
 
-	// max_p = max_p > t->priority ? max_p : t->priority; /* 현재 thread의 우선 순위와 donations list 중에 큰 priority로 갱신 */
-	t->priority = max_p; /* t의 priority 값 갱신 */
+/* 락의 donors 힙 비교 함수: 우선순위가 높은 대기자가 루트 */
+bool donor_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+	return heap_entry(a, struct thread, d_elem)->priority
+		< heap_entry(b, struct thread, d_elem)->priority;
+}
 
-	return;
+/* 스레드의 held_locks 힙 비교 함수: 가장 높은 대기자를 가진 락이 루트 */
+static bool held_lock_less(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED)
+{
+	return lock_donor_priority(heap_entry(a, struct lock, held_elem))
+		< lock_donor_priority(heap_entry(b, struct lock, held_elem));
 }
 
-void donate_priority(struct thread *donor, struct thread *holder)
+/* T의 우선순위를 base_priority와 보유한 락의 대기자 중 최댓값으로 다시 정한다.
+   우선순위가 바뀌었고 T가 락을 기다리는 중이면, 그 락의 donors 힙과
+   holder의 held_locks 힙에서 T의 위치를 고친 뒤 holder로 올라가 반복한다.
+   우선순위가 그대로인 곳에서 멈추므로 각 단계는 힙 연산 두 번(O(log n))이다. */
+void recal_priority(struct thread *t)
 {
-	struct thread *curr = thread_current();
-	/* holder가 없거나 donor이면 함수 종료 */
-	if(holder == NULL || holder == donor)		
-		return;				
-	
-	int depth = 0;
+	/* MLFQS에서는 donation을 쓰지 않는다. */
+	if (thread_mlfqs)
+		return;
+
+	enum intr_level old_level = intr_disable();
 
-	while (depth < 8 && holder != NULL)
+	while (t != NULL)
 	{
-		/* donor의 우선순위가 holder보다 높을 때만 donation */
-		if (donor->priority > holder->priority)
-		{			
-			/* 중복 삽입 방지 */
-			bool already_donated = false;
-			for (struct list_elem *e = list_begin(&holder->donations); e != list_end(&holder->donations); e = list_next(e))
-			{
-				struct thread *t = list_entry(e, struct thread, d_elem);
-				if (t == donor)
-				{
-					already_donated = true;
-					break;
-				}
-			}
-
-			/* 중복이 아닐 경우에만 donations 리스트에 삽입 */
-			if (!already_donated)			
-			{	
-				enum intr_level old_level = intr_disable();  /* 인터럽트 비활성화 */
-				
-				list_insert_ordered(&holder->donations, &donor->d_elem, cmp_priority, NULL);			
-				
-				intr_set_level(old_level);   /* 인터럽트 복구 */
-			}
-
-			recal_priority(holder);  /* 우선순위 재계산 */			
+		int max_p = t->base_priority; /* base_priority로 초기화 */
+
+		/* 가장 높은 대기자를 가진 락이 held_locks의 루트에 있다 */
+		if (!heap_empty(&t->held_locks))
+		{
+			struct lock *top = heap_entry(heap_top(&t->held_locks), struct lock, held_elem);
+			int donated = lock_donor_priority(top);
+			max_p = max_p > donated ? max_p : donated;
 		}
 
-		/* holder의 wait_on_lock이 있을 경우 반복 호출 */
-		if (holder->wait_on_lock != NULL)
+		if (t->priority == max_p)
+			break;
+
+		/* READY 상태면 새 우선순위의 큐로 옮겨야 비트맵 검색이 맞다. */
+		if (t->status == THREAD_READY)
 		{
-			donor = holder;
-			holder = holder->wait_on_lock->holder;
+			ready_remove(t);
+			t->priority = max_p;
+			ready_push(t);
 		}
 		else
+		{
+			t->priority = max_p; /* t의 priority 값 갱신 */
+			synch_requeue(t);    /* 세마포어/조건 변수 대기 힙에서 위치 갱신 */
+		}
+
+		/* 기다리는 락이 있으면 키가 바뀐 것을 반영하고 holder로 올라간다 */
+		struct lock *lock = t->wait_on_lock;
+		if (lock == NULL || !heap_contains(&lock->donors, &t->d_elem))
 			break;
+		heap_update(&lock->donors, &t->d_elem);
 
-		depth++;
+		t = lock->holder;
+		if (t != NULL)
+			heap_update(&t->held_locks, &lock->held_elem);
 	}
+
+	intr_set_level(old_level);
 }
 
-bool is_in_donations(struct thread *donor, struct thread *holder)
+/* DONOR가 DONOR->wait_on_lock을 기다리기 시작할 때 호출한다.
+   DONOR를 락의 donors 힙에 넣고, holder가 있으면 holder부터
+   wait_on_lock 사슬을 따라 우선순위를 다시 계산한다. */
+void donate_priority(struct thread *donor)
 {
-	struct list_elem *donor_d_elem = &donor->d_elem;
-	
-	for(struct list_elem *e = list_begin(&holder->donations); e != list_end(&holder->donations); e = list_next(e))
+	struct lock *lock = donor->wait_on_lock;
+
+	/* 기다리는 락이 없거나 MLFQS이면 함수 종료 */
+	if (lock == NULL || thread_mlfqs)
+		return;
+
+	enum intr_level old_level = intr_disable();
+
+	heap_push(&lock->donors, &donor->d_elem);
+	if (lock->holder != NULL)
 	{
-		if(e == donor_d_elem)
-			return true;
+		heap_update(&lock->holder->held_locks, &lock->held_elem);
+		recal_priority(lock->holder);
+	}
+
+	intr_set_level(old_level);
+}
+
+/* CACHE에서 페이지 하나를 꺼낸다. 비어 있으면 NULL */
+static void *
+recycle_get (struct recycle_cache *cache)
+{
+	void *page = NULL;
+	enum intr_level old_level = intr_disable ();
+
+	if (cache->cnt > 0)
+		page = cache->pages[--cache->cnt];
+	intr_set_level (old_level);
+	return page;
+}
+
+/* PAGE를 CACHE에 넣는다. 가득 차 있으면 false */
+static bool
+recycle_put (struct recycle_cache *cache, void *page)
+{
+	bool ok = false;
+	enum intr_level old_level = intr_disable ();
+
+	if (cache->cnt < RECYCLE_MAX) {
+		cache->pages[cache->cnt++] = page;
+		ok = true;
 	}
+	intr_set_level (old_level);
+	return ok;
+}
 
-	return false;
-}
\ No newline at end of file
+/* 죽은 스레드 T의 페이지를 캐시에 돌려주거나, 캐시가 차 있으면 해제한다. */
+static void
+thread_page_free (struct thread *t)
+{
+	if (!recycle_put (&thread_recycle, t))
+		palloc_free_page (t);
+}
+
+/* 모든 슬롯이 NULL인 fdt 페이지를 반환한다. 실패하면 NULL */
+struct file **
+fdt_alloc (void)
+{
+	struct file **fdt = recycle_get (&fdt_recycle);
+
+	return fdt != NULL ? fdt : palloc_get_page (PAL_ZERO);
+}
+
+/* FDT를 돌려준다. 호출하는 쪽은 사용한 슬롯을 모두 NULL로 비워 두어야 하며,
+   그러면 다음 fdt_alloc()은 페이지를 다시 지우지 않고 그대로 쓸 수 있다. */
+void
+fdt_free (struct file **fdt)
+{
+	if (!recycle_put (&fdt_recycle, fdt))
+		palloc_free_page (fdt);
+}
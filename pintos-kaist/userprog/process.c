@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/prefetch.h"
 #endif
 
 static void process_cleanup (void);
@@ -184,6 +185,11 @@ __do_fork (void *aux) {
 	/* 부모 스레드의 next_fd 값 복사 */
 	curr->next_fd = parent->next_fd;
 
+#ifdef VM
+	/* uffd 디스크립터 복제 */
+	uffd_fork(curr, parent);
+#endif
+
 	/* 부모 스레드의 데이터 복제 후 부모 스레드 block 해제 */
 	sema_up(&curr->load_sema);
 
@@ -313,8 +319,14 @@ process_exit (void) {
 			curr->fdt[i] = NULL;
 			}
 	}
-	palloc_free_page(curr->fdt);
+	/* 모든 슬롯을 비웠으므로 지우지 않고 재사용할 수 있게 돌려준다 */
+	fdt_free(curr->fdt);
 	curr->fdt = NULL;
+
+#ifdef VM
+	/* uffd 디스크립터 닫기 */
+	uffd_close_all();
+#endif
 	
 	process_cleanup ();
 
@@ -331,6 +343,8 @@ process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
 #ifdef VM
+	prefetch_record (curr);
+	uffd_release (curr);
 	supplemental_page_table_kill (&curr->spt);
 #endif
 
@@ -453,6 +467,9 @@ load (const char *file_name, struct intr_frame *if_) {
 		printf ("load: %s: open failed\n", file_name);
 		goto done;
 	}	
+#ifdef VM
+	prefetch_begin (file);
+#endif
 
         /* 실행 파일 헤더를 읽어 검증한다. */
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
@@ -791,6 +808,11 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 					writable, lazy_load_segment, aux))
 			return false;
 
+		/* 지난 실행에서 쓰였거나 작은 실행 파일의 페이지는 바로 올린다.
+		 * 실패하면 지연 적재로 남는다. */
+		if (prefetch_is_hot (upage, page_read_bytes > 0))
+			vm_claim_page (upage);
+
 		/* 다음 주소로 이동. */
 		read_bytes -= page_read_bytes;
 		zero_bytes -= page_zero_bytes;
@@ -120,6 +120,51 @@ syscall_handler (struct intr_frame *f) {
         case SYS_MUNMAP:
             sys_munmap(f->R.rdi);
             break;
+
+#ifdef VM
+		case SYS_UFFD_CREATE:
+			f->R.rax = uffd_create();
+			break;
+
+		case SYS_UFFD_REGISTER:
+			f->R.rax = uffd_register(f->R.rdi, (void *)f->R.rsi, f->R.rdx);
+			break;
+
+		case SYS_UFFD_READ:
+			validate_addr((void *)f->R.rsi);
+			validate_addr((uint8_t *)f->R.rsi + sizeof (struct uffd_msg) - 1);
+			f->R.rax = uffd_read(f->R.rdi, (struct uffd_msg *)f->R.rsi);
+			break;
+
+		case SYS_UFFD_COPY:
+			/* LENGTH가 PGSIZE 이하이므로 처음과 끝 바이트만 보면
+			 * 그 사이의 페이지도 모두 사용자 영역이다. */
+			if (f->R.r10 == 0 || f->R.r10 > PGSIZE) {
+				f->R.rax = false;
+				break;
+			}
+			validate_addr((void *)f->R.rdx);
+			validate_addr((uint8_t *)f->R.rdx + f->R.r10 - 1);
+			f->R.rax = uffd_copy(f->R.rdi, (void *)f->R.rsi, (const void *)f->R.rdx, f->R.r10);
+			break;
+
+		case SYS_MEMSTAT:
+			validate_addr((void *)f->R.rdi);
+			validate_addr((uint8_t *)f->R.rdi + sizeof (struct memstat) - 1);
+			f->R.rax = vm_memstat((struct memstat *)f->R.rdi);
+			break;
+#endif
+
+		case SYS_CLOCK_GETTIME:
+			validate_addr((void *)f->R.rsi);
+			f->R.rax = sys_clock_gettime(f->R.rdi, (struct timespec *)f->R.rsi);
+			break;
+
+		case SYS_SCHEDSTAT:
+			validate_addr((void *)f->R.rdi);
+			validate_addr((uint8_t *)f->R.rdi + sizeof (struct schedstat) - 1);
+			f->R.rax = thread_schedstat((struct schedstat *)f->R.rdi);
+			break;
 	
 	default:
 		break;
@@ -368,6 +413,16 @@ unsigned tell(int fd)
 void close(int fd)
 {
 	struct thread *curr = thread_current();	
+
+#ifdef VM
+	/* uffd 디스크립터는 별도의 테이블에서 관리 */
+	if(fd >= UFFD_FD_BASE)
+	{
+		if(!uffd_close(fd))
+			sys_exit(-1);
+		return;
+	}
+#endif
 	
 	/* 파일이 없거나 표준 입력/에러이거나 할당 가능한 fd 이상이면 종료 */
 	if(fd == 0 || fd == 2 || fd > FD_MAX)
@@ -405,6 +460,10 @@ void *sys_mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 	if (spt_find_page(&thread_current()->spt, addr))
         return NULL;
 
+	/* fd가 -1이면 파일 없이 0으로 채워지는 익명 매핑 */
+	if (fd == -1)
+		return length > 0 ? do_mmap(addr, length, writable, NULL, 0) : NULL;
+
     /* file이 없는 경우 */	
     if (thread_current()->fdt[fd] == NULL)
         return NULL;
@@ -423,6 +482,21 @@ void sys_munmap(void *addr)
 	do_munmap(addr);
 }
 
+/* CLOCK_ID 시계의 현재 시각을 TS에 쓴다. 성공하면 0, 실패하면 -1 */
+int sys_clock_gettime(int clock_id, struct timespec *ts)
+{
+	if (clock_id != CLOCK_MONOTONIC)
+		return -1;
+
+	/* 구조체 끝도 유저 영역이어야 한다 */
+	validate_addr((uint8_t *)ts + sizeof *ts - 1);
+
+	uint64_t ns = timer_ns();
+	ts->tv_sec = ns / 1000000000;
+	ts->tv_nsec = ns % 1000000000;
+	return 0;
+}
+
 
 struct thread* get_child(tid_t tid)
 {
@@ -1,7 +1,41 @@
 /* anon.c: 디스크 이미지가 아닌 페이지, 즉 anonymous page를 위한 구현입니다. */
 
+#include <bitmap.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include "threads/interrupt.h"
+
+/* 페이지 하나를 담는 데 필요한 섹터 수 */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
+
+/* 스왑 장치 하나. 장치마다 슬롯 할당 비트맵과 우선순위를 가진다. */
+struct swap_dev {
+	struct disk *disk;
+	int chan_no, dev_no;        /* IDE 위치 (hdCHAN:DEV) */
+	int prio;                   /* 클수록 먼저 쓴다 */
+	struct bitmap *slots;       /* 슬롯 할당 비트맵 */
+};
+
+/* 장치는 최대 IDE 슬롯 수만큼. swap_idx는 (장치 안의 슬롯 * SWAP_DEV_MAX
+ * + 장치 번호)로 인코딩한다. */
+#define SWAP_DEV_MAX 4
+/* 같은 우선순위 장치 사이에서 이만큼의 페이지를 연달아 할당한 뒤 다음
+ * 장치로 넘어간다 (클러스터 단위 스트라이핑). */
+#define SWAP_CLUSTER 8
+
+/* 우선순위 내림차순으로 정렬된 스왑 장치 목록과 이를 보호하는 락 */
+static struct swap_dev swap_devs[SWAP_DEV_MAX];
+static int swap_dev_cnt;
+static struct lock swap_lock;
+static unsigned swap_rotor;         /* 같은 우선순위 묶음 안에서 다음 장치 */
+static unsigned swap_cluster_left;  /* 현재 장치에 남은 클러스터 페이지 수 */
+
+/* -swap 커널 옵션 값. "CHAN:DEV:PRIO"를 쉼표로 이은 목록이며 없으면
+ * 기본 스왑 디스크(hd1:1) 하나만 쓴다. */
+const char *swap_option;
 
 /* 아래 줄부터는 수정하지 마세요. */
 static struct disk *swap_disk;
@@ -17,40 +51,400 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
+/* SWAP_DEVS에서 A가 B보다 앞에 와야 하면 true. 우선순위 내림차순이며,
+ * 같은 우선순위 안에서는 (장치 번호, 채널) 순으로 두어 이웃한 장치가
+ * 서로 다른 채널에 있도록 한다. */
+static bool
+swap_dev_before (const struct swap_dev *a, const struct swap_dev *b) {
+	if (a->prio != b->prio)
+		return a->prio > b->prio;
+	if (a->dev_no != b->dev_no)
+		return a->dev_no < b->dev_no;
+	return a->chan_no < b->chan_no;
+}
+
+/* hdCHAN_NO:DEV_NO를 우선순위 PRIO의 스왑 장치로 등록합니다. */
+static void
+swap_dev_add (int chan_no, int dev_no, int prio) {
+	struct disk *disk = disk_get (chan_no, dev_no);
+	struct swap_dev new, *dev;
+	int i;
+
+	if (disk == NULL || swap_dev_cnt >= SWAP_DEV_MAX)
+		return;
+	for (i = 0; i < swap_dev_cnt; i++)
+		if (swap_devs[i].disk == disk)
+			return;
+
+	new.disk = disk;
+	new.chan_no = chan_no;
+	new.dev_no = dev_no;
+	new.prio = prio;
+	for (i = swap_dev_cnt; i > 0 && swap_dev_before (&new, &swap_devs[i - 1]); i--)
+		swap_devs[i] = swap_devs[i - 1];
+
+	dev = &swap_devs[i];
+	*dev = new;
+	dev->slots = bitmap_create (disk_size (disk) / SECTORS_PER_PAGE);
+	if (dev->slots == NULL)
+		PANIC ("swap: out of memory for slot bitmap of %d sectors", disk_size (disk));
+	swap_dev_cnt++;
+}
+
+/* -swap 항목의 숫자 필드 S를 읽습니다. 숫자가 아니면 PANIC. */
+static int
+swap_parse_num (const char *s, const char *what) {
+	const char *p = s;
+
+	if (*p == '-')
+		p++;
+	if (*p == '\0')
+		PANIC ("bad -swap %s `%s'", what, s);
+	for (; *p != '\0'; p++)
+		if (!isdigit (*p))
+			PANIC ("bad -swap %s `%s'", what, s);
+	return atoi (s);
+}
+
 /* anonymous page 관련 데이터를 초기화합니다. */
 void
 vm_anon_init (void) {
 	/* TODO: swap_disk를 설정해야 합니다. */
 	swap_disk = disk_get(1,1);		
+	lock_init (&swap_lock);
+
+	/* -swap 옵션이 없으면 기본 스왑 디스크 하나만 쓴다.
+	 * 스왑 디스크가 하나도 없으면 익명 페이지는 교체되지 않는다. */
+	swap_cluster_left = SWAP_CLUSTER;
+	if (swap_option == NULL) {
+		if (swap_disk != NULL)
+			swap_dev_add (1, 1, 0);
+		return;
+	}
+
+	char *spec, *save_ptr;
+	char buf[64];
+	if (strlcpy (buf, swap_option, sizeof buf) >= sizeof buf)
+		PANIC ("-swap option too long (max %zu characters): `%s'",
+				sizeof buf - 1, swap_option);
+	for (spec = strtok_r (buf, ",", &save_ptr); spec != NULL;
+			spec = strtok_r (NULL, ",", &save_ptr)) {
+		char *chan = spec, *dev, *prio;
+		int chan_no, dev_no;
+
+		dev = strchr (chan, ':');
+		if (dev == NULL)
+			PANIC ("bad -swap device `%s' (expected CHAN:DEV[:PRIO])", spec);
+		*dev++ = '\0';
+		prio = strchr (dev, ':');
+		if (prio != NULL)
+			*prio++ = '\0';
+		chan_no = swap_parse_num (chan, "channel");
+		dev_no = swap_parse_num (dev, "device number");
+		/* 채널 0은 부트 디스크(hd0:0)와 파일 시스템 디스크(hd0:1)다. */
+		if (chan_no <= 0 || chan_no >= CHANNEL_CNT)
+			PANIC ("bad -swap channel `%s' (must be 1..%d)", chan, CHANNEL_CNT - 1);
+		if (dev_no != 0 && dev_no != 1)
+			PANIC ("bad -swap device number `%s'", dev);
+		swap_dev_add (chan_no, dev_no,
+				prio != NULL ? swap_parse_num (prio, "priority") : 0);
+	}
+}
+
+/* 설정된 스왑 장치마다 (채널 * 2 + 장치 번호)번 비트를 켠 마스크를
+ * 반환합니다. 벤치마크가 int 0x45로 읽어 장치별 디스크 카운터를 합칩니다.
+ * 장치 목록은 vm_anon_init() 뒤로 바뀌지 않습니다. */
+unsigned
+swap_dev_mask (void) {
+	unsigned mask = 0;
+
+	for (int i = 0; i < swap_dev_cnt; i++)
+		mask |= 1u << (swap_devs[i].chan_no * 2 + swap_devs[i].dev_no);
+	return mask;
+}
+
+/* 빈 스왑 슬롯 하나를 할당해 번호를 반환합니다. 없으면 SWAP_NONE.
+ * 우선순위가 높은 장치 묶음부터 채우고, 같은 우선순위 장치 사이에서는
+ * SWAP_CLUSTER 페이지씩 돌아가며 할당해 입출력을 여러 장치에 나눈다. */
+static size_t
+swap_alloc (void) {
+	size_t slot = SWAP_NONE;
+	int first, last, k;
+
+	lock_acquire (&swap_lock);
+	for (first = 0; first < swap_dev_cnt && slot == SWAP_NONE; first = last) {
+		int n;
+
+		for (last = first; last < swap_dev_cnt
+				&& swap_devs[last].prio == swap_devs[first].prio; last++)
+			continue;
+		n = last - first;
+
+		for (k = 0; k < n; k++) {
+			int d = first + (swap_rotor + k) % n;
+			size_t idx = bitmap_scan_and_flip (swap_devs[d].slots, 0, 1, false);
+
+			if (idx != BITMAP_ERROR) {
+				slot = idx * SWAP_DEV_MAX + d;
+				/* 장치가 가득 차 건너뛰었다면 그 장치에서 새 클러스터를 시작 */
+				if (k != 0) {
+					swap_rotor += k;
+					swap_cluster_left = SWAP_CLUSTER;
+				}
+				if (--swap_cluster_left == 0) {
+					swap_rotor++;
+					swap_cluster_left = SWAP_CLUSTER;
+				}
+				break;
+			}
+		}
+	}
+	lock_release (&swap_lock);
+	return slot;
+}
+
+/* 스왑 슬롯 SLOT을 반납합니다. */
+static void
+swap_free (size_t slot) {
+	lock_acquire (&swap_lock);
+	bitmap_reset (swap_devs[slot % SWAP_DEV_MAX].slots, slot / SWAP_DEV_MAX);
+	lock_release (&swap_lock);
+}
+
+/* supplemental_page_table_kill()이 부릅니다. PAGES(hash_elem.list_elem으로
+ * 엮인 페이지 목록)의 익명 페이지가 가진 스왑 슬롯을 장치별로 모아
+ * swap_lock을 한 번만 잡고 모두 반납합니다. 반납한 페이지는 swap_idx를
+ * 비워 이후 destroy에서 다시 반납하지 않게 합니다. */
+void
+anon_swap_free_pages (struct list *pages) {
+	lock_acquire (&swap_lock);
+	for (int d = 0; d < swap_dev_cnt; d++)
+		for (struct list_elem *e = list_begin (pages); e != list_end (pages);
+				e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, hash_elem.list_elem);
+			size_t slot;
+
+			if (VM_TYPE (page->operations->type) != VM_ANON)
+				continue;
+			slot = page->anon.swap_idx;
+			if (slot == SWAP_NONE || slot % SWAP_DEV_MAX != (size_t) d)
+				continue;
+			bitmap_reset (swap_devs[d].slots, slot / SWAP_DEV_MAX);
+			page->anon.swap_idx = SWAP_NONE;
+		}
+	lock_release (&swap_lock);
+}
+
+/* 스왑 슬롯 SLOT의 내용을 KVA로 읽어 옵니다. */
+static void
+swap_read (size_t slot, void *kva) {
+	struct disk *disk = swap_devs[slot % SWAP_DEV_MAX].disk;
+	disk_sector_t sector = slot / SWAP_DEV_MAX * SECTORS_PER_PAGE;
+
+	for (int i = 0; i < SECTORS_PER_PAGE; i++)
+		disk_read (disk, sector + i, kva + i * DISK_SECTOR_SIZE);
+}
+
+/* KVA의 내용을 스왑 슬롯 SLOT에 기록합니다. */
+static void
+swap_write (size_t slot, const void *kva) {
+	struct disk *disk = swap_devs[slot % SWAP_DEV_MAX].disk;
+	disk_sector_t sector = slot / SWAP_DEV_MAX * SECTORS_PER_PAGE;
+
+	for (int i = 0; i < SECTORS_PER_PAGE; i++)
+		disk_write (disk, sector + i, kva + i * DISK_SECTOR_SIZE);
 }
 
 /* 파일 매핑을 초기화합니다. */
 bool
 anon_initializer (struct page *page, enum vm_type type, void *kva) {
+	/* uninit과 anon은 유니온을 공유하므로 덮어쓰기 전에 aux를 읽어 둡니다. */
+	void *aux = page->uninit.aux;
+
 	/* 핸들러를 설정합니다. */
 	page->operations = &anon_ops;	
 
 	/* anon_page 초기화 */
 	struct anon_page *anon_page = &page->anon;	
-	anon_page->swap_idx = -1;	
+	anon_page->swap_idx = SWAP_NONE;	
+	anon_page->patterned = false;
+	anon_page->mmap_base = (type & VM_MARKER_1) ? aux : NULL;
 	
 	return true;	
 }
 
-/* swap 영역에서 내용을 읽어 페이지를 불러옵니다. */
+/* PAGE가 익명 mmap으로 만든 페이지면 그 매핑의 시작 주소를, 아니면 NULL을
+ * 반환합니다. 익명 mmap 페이지는 VM_ANON | VM_MARKER_1 타입이며, 아직
+ * 초기화되지 않은 동안에는 uninit.aux에 시작 주소를 담고 있습니다. */
+void *
+anon_mmap_base (struct page *page) {
+	switch (VM_TYPE (page->operations->type)) {
+	case VM_UNINIT:
+		if (VM_TYPE (page->uninit.type) == VM_ANON
+				&& (page->uninit.type & VM_MARKER_1))
+			return page->uninit.aux;
+		return NULL;
+	case VM_ANON:
+		return page->anon.mmap_base;
+	default:
+		return NULL;
+	}
+}
+
+/* KVA의 페이지가 하나의 64비트 값으로만 채워져 있으면 그 값을 *PATTERN에
+ * 담고 true를 반환합니다. 0으로 채워진 페이지도 여기에 해당합니다. */
+static bool
+page_is_pattern (const void *kva, uint64_t *pattern) {
+	const uint64_t *word = kva;
+	size_t i;
+
+	for (i = 1; i < PGSIZE / sizeof *word; i++)
+		if (word[i] != word[0])
+			return false;
+	*pattern = word[0];
+	return true;
+}
+
+/* KVA의 페이지를 PATTERN으로 채웁니다. */
+static void
+page_fill_pattern (void *kva, uint64_t pattern) {
+	uint64_t *word = kva;
+	size_t i;
+
+	for (i = 0; i < PGSIZE / sizeof *word; i++)
+		word[i] = pattern;
+}
+
+/* swap 영역에서 내용을 읽어 페이지를 불러옵니다.
+ * 슬롯은 반납하지 않고 스왑 캐시로 남겨 둡니다. 페이지가 수정되지 않은 채
+ * 다시 쫓겨나면 디스크에 쓰지 않고 그대로 버릴 수 있습니다. */
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
+
+	if (anon_page->patterned)
+		page_fill_pattern (kva, anon_page->pattern);
+	else if (anon_page->swap_idx != SWAP_NONE)
+		swap_read (anon_page->swap_idx, kva);
+	return true;
 }
 
-/* 페이지 내용을 swap 영역에 기록하여 내보냅니다. */
+/* 페이지 내용을 swap 영역에 기록하여 내보냅니다. 교체 경로가 frame_lock을
+ * 놓은 채 호출합니다. 스왑 캐시에 슬롯(또는 패턴)이 남아 있고 소유
+ * 프로세스의 pml4에서 dirty 비트가 꺼져 있으면 내용이 그대로이므로 쓰지
+ * 않습니다. 0이나 하나의 64비트 값으로만 채워진 페이지는 슬롯을 쓰지 않고
+ * 패턴만 기록해 두었다가 스왑-인 때 메모리에서 다시 만듭니다. 수정된
+ * 페이지는 가지고 있던 슬롯에 덮어씁니다. */
 static bool
 anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = frame->owner->pml4;
+	enum intr_level old_level;
+	bool dirty;
+
+	/* dirty 비트를 읽고 매핑을 지우는 사이에 소유 프로세스가 다시 쓰지
+	 * 못하도록 인터럽트를 끈 채로 처리한다. 매핑을 지운 뒤에는 내용이
+	 * 바뀌지 않으므로 아래에서 안전하게 검사할 수 있다. */
+	old_level = intr_disable ();
+	dirty = pml4_is_dirty (pml4, page->va);
+	pml4_clear_page (pml4, page->va);
+	intr_set_level (old_level);
+
+	if (!dirty && (anon_page->patterned || anon_page->swap_idx != SWAP_NONE))
+		return true;
+
+	if (page_is_pattern (frame->kva, &anon_page->pattern)) {
+		if (anon_page->swap_idx != SWAP_NONE) {
+			swap_free (anon_page->swap_idx);
+			anon_page->swap_idx = SWAP_NONE;
+		}
+		anon_page->patterned = true;
+		return true;
+	}
+	anon_page->patterned = false;
+
+	if (anon_page->swap_idx == SWAP_NONE) {
+		anon_page->swap_idx = swap_alloc ();
+		if (anon_page->swap_idx == SWAP_NONE) {
+			/* 슬롯이 없으면 매핑을 되살리고 교체를 포기한다. */
+			pml4_set_page (pml4, page->va, frame->kva, page->writable);
+			pml4_set_dirty (pml4, page->va, true);
+			return false;
+		}
+	}
+	swap_write (anon_page->swap_idx, frame->kva);
+	return true;
+}
+
+/* 세탁 스레드가 메모리에 있는 PAGE의 내용을 미리 스왑에 기록합니다.
+ * 매핑은 그대로 둔 채 dirty 비트를 먼저 지우고 기록하므로, 기록 도중 소유
+ * 프로세스가 다시 쓰면 dirty 비트가 다시 켜져 교체 때 버려지지 않습니다.
+ * 슬롯이 없으면 dirty 비트를 되돌리고 false를 반환합니다. */
+bool
+anon_launder (struct page *page) {
+	struct anon_page *anon_page = &page->anon;
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = frame->owner->pml4;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	pml4_set_dirty (pml4, page->va, false);
+	intr_set_level (old_level);
+
+	if (page_is_pattern (frame->kva, &anon_page->pattern)) {
+		if (anon_page->swap_idx != SWAP_NONE) {
+			swap_free (anon_page->swap_idx);
+			anon_page->swap_idx = SWAP_NONE;
+		}
+		anon_page->patterned = true;
+		return true;
+	}
+	anon_page->patterned = false;
+
+	if (anon_page->swap_idx == SWAP_NONE) {
+		anon_page->swap_idx = swap_alloc ();
+		if (anon_page->swap_idx == SWAP_NONE) {
+			pml4_set_dirty (pml4, page->va, true);
+			return false;
+		}
+	}
+	swap_write (anon_page->swap_idx, frame->kva);
+	return true;
+}
+
+/* 스왑에 나가 있는 PAGE의 내용을 KVA로 읽어 옵니다. fork에서 부모의
+ * 쫓겨난 페이지를 자식에게 복사할 때 씁니다. */
+void
+anon_swap_read (struct page *page, void *kva) {
+	if (page->anon.patterned)
+		page_fill_pattern (kva, page->anon.pattern);
+	else if (page->anon.swap_idx != SWAP_NONE)
+		swap_read (page->anon.swap_idx, kva);
 }
 
 /* anonymous page를 파괴합니다. PAGE는 호출자가 해제합니다. */
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+	struct frame *frame;
+	struct thread *curr = thread_current ();
+
+	/* 프레임을 반납하고 매핑을 지웁니다. PTE를 지워 두어야 이후
+	 * pml4_destroy()가 같은 페이지를 다시 해제하지 않습니다. */
+	lock_acquire (&frame_lock);
+	frame = vm_frame_settle (page);
+	if (frame != NULL) {
+		list_remove (&frame->frame_elem);
+		pml4_clear_page (curr->pml4, page->va);
+		palloc_free_page (frame->kva);
+		free (frame);
+		page->frame = NULL;
+	}
+	lock_release (&frame_lock);
+
+	if (anon_page->swap_idx != SWAP_NONE) {
+		swap_free (anon_page->swap_idx);
+		anon_page->swap_idx = SWAP_NONE;
+	}
 }
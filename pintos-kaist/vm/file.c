@@ -1,11 +1,62 @@
 /* file.c: 메모리 기반 파일 객체(mmaped object) 구현입니다. */
 
+#include <round.h>
+#include <string.h>
+#include <mman.h>
 #include "vm/vm.h"
+#include "userprog/syscall.h"
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 void file_backed_destroy (struct page *page);
 
+/* 공유 매핑 페이지 인덱스의 항목.
+ * 같은 inode의 같은 오프셋을 MAP_SHARED로 매핑한 모든 페이지는 이 항목의
+ * 프레임 하나를 함께 매핑합니다. 프레임은 다른 프레임처럼 교체될 수 있으며,
+ * 그때 모든 매퍼의 PTE를 지우고 수정된 경우에만 write-back 합니다. 다음
+ * 폴트를 낸 매퍼가 파일에서 다시 읽어 새 프레임으로 삼습니다. 마지막 매퍼가
+ * 떨어져 나갈 때 한 번만 write-back 하고 프레임을 해제합니다.
+ * write-back은 락을 놓고 하며, 그동안 writing이 켜져 있어 파일에서 다시
+ * 읽으려는 매퍼는 shared_written에서 기다립니다.
+ * 락 순서는 filesys_lock -> frame_lock -> shared_lock 입니다. */
+struct shared_page {
+	struct inode *inode;            /* 키: 파일 */
+	off_t ofs;                      /* 키: 파일 내 오프셋 */
+	struct mmap_desc *desc;         /* write-back에 쓸 매핑 (참조를 하나 잡는다) */
+	size_t read_bytes;              /* write-back 할 바이트 수 */
+	struct frame *frame;            /* 공유하는 프레임 (교체되었으면 NULL) */
+	int ref_cnt;                    /* 이 프레임을 매핑한 페이지 수 */
+	bool dirty;                     /* 떨어져 나간 매퍼의 dirty 비트 누적 */
+	bool writing;                   /* 락 밖에서 파일에 기록하는 중 */
+	struct list mappers;            /* 매핑한 page 목록 */
+	struct hash_elem elem;
+};
+
+/* (inode, 오프셋) -> shared_page 인덱스와 이를 보호하는 락 */
+static struct hash shared_pages;
+static struct lock shared_lock;
+static struct condition shared_written;  /* writing이 꺼질 때 알린다 */
+
+static uint64_t
+shared_page_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct shared_page *sp = hash_entry (e, struct shared_page, elem);
+	return hash_bytes (&sp->inode, sizeof sp->inode) ^ hash_int (sp->ofs);
+}
+
+static bool
+shared_page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct shared_page *a = hash_entry (a_, struct shared_page, elem);
+	const struct shared_page *b = hash_entry (b_, struct shared_page, elem);
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	return a->ofs < b->ofs;
+}
+
+/* mmap_desc의 참조 카운트를 보호하는 락. fork로 자식과 기술자를 공유하므로
+ * 여러 프로세스가 동시에 만질 수 있다. */
+static struct lock desc_lock;
+
 /* 이 구조체는 수정하지 않습니다. */
 static const struct page_operations file_ops = {
 	.swap_in = file_backed_swap_in,
@@ -17,7 +68,81 @@ static const struct page_operations file_ops = {
 /* file VM을 초기화합니다. */
 void
 vm_file_init (void) {
-	
+	hash_init (&shared_pages, shared_page_hash, shared_page_less, NULL);
+	lock_init (&shared_lock);
+	cond_init (&shared_written);
+	lock_init (&desc_lock);
+}
+
+/* DESC의 참조를 하나 늘리고 DESC를 반환합니다. */
+struct mmap_desc *
+mmap_desc_get (struct mmap_desc *desc) {
+	lock_acquire (&desc_lock);
+	desc->ref_cnt++;
+	lock_release (&desc_lock);
+	return desc;
+}
+
+/* DESC의 참조를 하나 놓습니다. 마지막 참조였다면 파일을 닫고 해제합니다. */
+void
+mmap_desc_put (struct mmap_desc *desc) {
+	bool last;
+
+	lock_acquire (&desc_lock);
+	last = --desc->ref_cnt == 0;
+	lock_release (&desc_lock);
+
+	if (last) {
+		file_close (desc->file);
+		free (desc);
+	}
+}
+
+/* 매핑 DESC의 IDX번째 페이지에 대응하는 파일 오프셋 */
+static off_t
+mmap_page_ofs (const struct mmap_desc *desc, size_t idx) {
+	return desc->ofs + idx * PGSIZE;
+}
+
+/* 매핑 DESC의 IDX번째 페이지에서 파일로부터 읽을 바이트 수.
+ * 나머지는 0으로 채운다. */
+static size_t
+mmap_page_read_bytes (const struct mmap_desc *desc, size_t idx) {
+	size_t skip = idx * PGSIZE;
+
+	if (skip >= desc->read_bytes)
+		return 0;
+	return desc->read_bytes - skip < PGSIZE ? desc->read_bytes - skip : PGSIZE;
+}
+
+/* 현재 스레드가 filesys_lock을 쥐고 있지 않으면 잡고 true를 반환합니다.
+ * read()/write()는 락을 쥔 채 사용자 버퍼에서 폴트를 내므로, 그 폴트의
+ * 교체 경로는 이미 쥔 락 아래에서 그대로 기록합니다. */
+static bool
+mmap_lock_filesys (void) {
+	if (lock_held_by_current_thread (&filesys_lock))
+		return false;
+	lock_acquire (&filesys_lock);
+	return true;
+}
+
+/* mmap_lock_filesys()가 잡은 락이면 놓습니다. */
+static void
+mmap_unlock_filesys (bool locked) {
+	if (locked)
+		lock_release (&filesys_lock);
+}
+
+/* mmap 페이지의 write-back은 모두 이 함수를 거쳐 시스템 콜과 같이
+ * filesys_lock 아래에서 기록합니다. frame_lock이나 shared_lock을 쥔 채
+ * 부르면 안 됩니다. */
+static off_t
+mmap_write_back (struct file *file, const void *buf, off_t size, off_t ofs) {
+	bool locked = mmap_lock_filesys ();
+	off_t written = file_write_at (file, buf, size, ofs);
+
+	mmap_unlock_filesys (locked);
+	return written;
 }
 
 /* 파일 기반 페이지를 초기화합니다. */
@@ -26,89 +151,552 @@ file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
 	/* 핸들러를 설정합니다. */
 	page->operations = &file_ops;
 
-	struct aux *aux = page->uninit.aux;	
+	struct mmap_desc *desc = (struct mmap_desc *) page->uninit.aux;	
 
 	/* file-backed_page 초기화 */
 	struct file_page *file_page = &page->file;
 
-	file_page->aux = aux;
+	file_page->desc = desc;
+	file_page->idx = (page->va - desc->base) / PGSIZE;
 	file_page->modified = false;	
+	file_page->shared = NULL;
 	
 	return true;
 }
 
-/* 파일에서 내용을 읽어 페이지를 불러옵니다. */
+static bool shared_attach (struct shared_page *sp, struct page *page,
+		struct frame **spare);
+static void shared_free_spare (struct frame *spare);
+static bool file_shared_swap_out (struct page *page);
+
+/* 파일에서 내용을 읽어 페이지를 불러옵니다. 공유 매핑 페이지면 교체된
+ * 공유 프레임을 다시 올리거나 다른 매퍼가 이미 올린 프레임을 매핑합니다. */
 bool
-file_backed_swap_in (struct page *page, void *kva) {
-	struct file_page *file_page UNUSED = &page->file;
+file_backed_swap_in (struct page *page, void *kva UNUSED) {
+	struct shared_page *sp = page->file.shared;
+	struct frame *spare;
+	bool success;
+
+	if (sp == NULL)
+		return lazy_load_mmap (page, page->file.desc);
+
+	lock_acquire (&shared_lock);
+	while (sp->writing)
+		cond_wait (&shared_written, &shared_lock);
+	success = shared_attach (sp, page, &spare);
+	lock_release (&shared_lock);
+	if (spare != NULL)
+		shared_free_spare (spare);
+	return success;
 }
 
-/* 페이지의 내용을 파일에 기록하여 내보냅니다. */
+/* 페이지의 내용을 파일에 기록하여 내보냅니다. 교체 경로가 frame_lock을
+ * 놓은 채 호출하며, 수정된 경우에만 파일에 씁니다. 수정된 페이지는
+ * filesys_lock을 먼저 잡은 뒤 매핑을 지우므로, 매핑이 사라진 이 페이지에
+ * 폴트를 내고 기록을 기다리는 스레드가 그 락을 쥐고 있는 일은 없습니다. */
 static bool
 file_backed_swap_out (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = frame->owner->pml4;
+	enum intr_level old_level;
+	bool dirty, locked;
+
+	if (file_page->shared != NULL)
+		return file_shared_swap_out (page);
+
+	old_level = intr_disable ();
+	dirty = pml4_is_dirty (pml4, page->va);
+	if (!dirty)
+		pml4_clear_page (pml4, page->va);
+	intr_set_level (old_level);
+	if (!dirty)
+		return true;
+
+	/* 교체 대상은 세탁되지 않으므로 dirty 비트는 그대로 켜져 있다. */
+	locked = mmap_lock_filesys ();
+	pml4_clear_page (pml4, page->va);
+	mmap_write_back (file_page->desc->file, frame->kva,
+			mmap_page_read_bytes (file_page->desc, file_page->idx),
+			mmap_page_ofs (file_page->desc, file_page->idx));
+	mmap_unlock_filesys (locked);
+	return true;
+}
+
+/* 세탁 스레드가 메모리에 있는 PAGE의 수정 내용을 미리 파일에 기록합니다.
+ * dirty 비트를 먼저 지우고 기록하므로 기록 도중의 쓰기는 다시 dirty로
+ * 남습니다. 세탁 스레드는 소유 프로세스의 주소 공간에 있지 않으므로
+ * 사용자 주소가 아닌 프레임의 kva에서 기록합니다. 소유 프로세스는 세탁이 끝날 때까지
+ * vm_frame_settle()에서 기다리므로 살아 있으며, 그 카운터는 다른 갱신
+ * 경로와 같이 frame_lock 아래에서 더합니다. */
+bool
+file_backed_launder (struct page *page) {
+	struct file_page *file_page = &page->file;
+	struct frame *frame = page->frame;
+	uint64_t *pml4 = frame->owner->pml4;
+	enum intr_level old_level;
+	bool dirty;
+
+	old_level = intr_disable ();
+	dirty = pml4_is_dirty (pml4, page->va);
+	pml4_set_dirty (pml4, page->va, false);
+	intr_set_level (old_level);
+
+	if (dirty) {
+		off_t written = mmap_write_back (file_page->desc->file, frame->kva,
+				mmap_page_read_bytes (file_page->desc, file_page->idx),
+				mmap_page_ofs (file_page->desc, file_page->idx));
+
+		lock_acquire (&frame_lock);
+		frame->owner->mstat.writeback_bytes += written;
+		lock_release (&frame_lock);
+	}
+	return true;
+}
+
+/* 폴트 경로에서 PAGE에 붙인 새 프레임을 공유 항목 SP와 맞춥니다. SP의
+ * 프레임이 교체되어 없으면 새 프레임에 파일 내용을 읽어 SP의 프레임으로
+ * 삼고, 이미 올라와 있으면 그 프레임을 매핑한 뒤 새 프레임을 *SPARE로
+ * 돌려줍니다. shared_lock을 잡은 채 호출하며, *SPARE는 호출자가 락을
+ * 놓은 뒤 shared_free_spare()로 해제합니다. */
+static bool
+shared_attach (struct shared_page *sp, struct page *page, struct frame **spare) {
+	struct thread *curr = thread_current ();
+	struct frame *frame = page->frame;
+
+	*spare = NULL;
+	if (sp->frame == NULL) {
+		if (file_read_at (sp->desc->file, frame->kva, sp->read_bytes, sp->ofs)
+				!= (off_t) sp->read_bytes)
+			return false;
+		memset (frame->kva + sp->read_bytes, 0, PGSIZE - sp->read_bytes);
+		sp->frame = frame;
+		return true;
+	}
+
+	pml4_clear_page (curr->pml4, page->va);
+	if (!pml4_set_page (curr->pml4, page->va, sp->frame->kva, page->writable))
+		return false;
+	page->frame = sp->frame;
+	*spare = frame;
+	return true;
+}
+
+/* shared_attach()가 돌려준 쓰지 않은 프레임을 해제합니다. 프레임은 아직
+ * pinned 상태라 그 사이 교체 대상이 되지 않습니다. */
+static void
+shared_free_spare (struct frame *spare) {
+	lock_acquire (&frame_lock);
+	list_remove (&spare->frame_elem);
+	lock_release (&frame_lock);
+	palloc_free_page (spare->kva);
+	free (spare);
+}
+
+/* 공유 매핑 페이지의 첫 폴트 때 uninit_initialize()가 부르는 initializer.
+ * 같은 inode의 같은 오프셋을 이미 누군가 올려 두었다면 폴트 경로에서 받은
+ * 새 프레임을 돌려주고 그 공유 프레임을 매핑하며, 아니면 새 프레임에
+ * 파일 내용을 읽어 들이고 인덱스에 등록합니다. */
+bool
+lazy_load_shared (struct page *page, void *aux) {
+	struct mmap_desc *desc = aux;
+	struct thread *curr = thread_current ();
+	struct frame *frame = page->frame, *spare = NULL;
+	size_t read_bytes = mmap_page_read_bytes (desc, page->file.idx);
+	struct shared_page key, *sp;
+	struct hash_elem *e;
+
+	key.inode = file_get_inode (desc->file);
+	key.ofs = mmap_page_ofs (desc, page->file.idx);
+
+	/* 같은 항목을 기록하는 중이면 파일 내용이 맞춰질 때까지 기다린다.
+	 * 마지막 매퍼가 기록한 항목은 그 뒤 인덱스에서 빠진다. */
+	lock_acquire (&shared_lock);
+	while ((e = hash_find (&shared_pages, &key.elem)) != NULL
+			&& hash_entry (e, struct shared_page, elem)->writing)
+		cond_wait (&shared_written, &shared_lock);
+	if (e != NULL) {
+		sp = hash_entry (e, struct shared_page, elem);
+		if (!shared_attach (sp, page, &spare)) {
+			lock_release (&shared_lock);
+			return false;
+		}
+	} else {
+		sp = malloc (sizeof *sp);
+		if (sp == NULL
+				|| file_read_at (desc->file, frame->kva, read_bytes, key.ofs)
+				   != (off_t) read_bytes) {
+			free (sp);
+			lock_release (&shared_lock);
+			return false;
+		}
+		memset (frame->kva + read_bytes, 0, PGSIZE - read_bytes);
+
+		sp->inode = key.inode;
+		sp->ofs = key.ofs;
+		sp->desc = mmap_desc_get (desc);
+		sp->read_bytes = read_bytes;
+		sp->frame = frame;
+		sp->ref_cnt = 0;
+		sp->dirty = false;
+		sp->writing = false;
+		list_init (&sp->mappers);
+		hash_insert (&shared_pages, &sp->elem);
+	}
+
+	sp->ref_cnt++;
+	list_push_back (&sp->mappers, &page->file.shared_elem);
+	page->file.shared = sp;
+	page->file.shared_owner = curr;
+	lock_release (&shared_lock);
+
+	if (spare != NULL)
+		shared_free_spare (spare);
+	return true;
+}
+
+/* 공유 프레임을 매핑한 페이지 PAGE의 매퍼 가운데 하나라도 최근에 접근했으면
+ * 모든 매퍼의 accessed 비트를 지우고 true를 반환합니다.
+ * frame_lock을 잡은 교체 경로에서 호출합니다. */
+bool
+file_shared_test_accessed (struct page *page) {
+	struct shared_page *sp = page->file.shared;
+	bool accessed = false;
+
+	lock_acquire (&shared_lock);
+	for (struct list_elem *e = list_begin (&sp->mappers);
+			e != list_end (&sp->mappers); e = list_next (e)) {
+		struct page *m = list_entry (e, struct page, file.shared_elem);
+		uint64_t *pml4 = m->file.shared_owner->pml4;
+
+		if (pml4_is_accessed (pml4, m->va)) {
+			pml4_set_accessed (pml4, m->va, false);
+			accessed = true;
+		}
+	}
+	lock_release (&shared_lock);
+	return accessed;
+}
+
+/* 공유 프레임을 매핑한 페이지 PAGE의 내용이 파일과 다르면 true.
+ * frame_lock을 잡은 교체 경로에서 호출합니다. */
+bool
+file_shared_is_dirty (struct page *page) {
+	struct shared_page *sp = page->file.shared;
+	bool dirty;
+
+	lock_acquire (&shared_lock);
+	dirty = sp->dirty;
+	for (struct list_elem *e = list_begin (&sp->mappers);
+			e != list_end (&sp->mappers) && !dirty; e = list_next (e)) {
+		struct page *m = list_entry (e, struct page, file.shared_elem);
+		dirty = pml4_is_dirty (m->file.shared_owner->pml4, m->va);
+	}
+	lock_release (&shared_lock);
+	return dirty;
+}
+
+/* 공유 프레임을 내보냅니다. 모든 매퍼의 PTE를 지우고, 누군가 수정했으면
+ * 한 번만 파일에 기록합니다. 교체 경로가 frame_lock을 놓은 채 호출합니다.
+ * 수정되었으면 filesys_lock을 먼저 잡고, 기록은 shared_lock도 놓은 뒤
+ * writing을 켠 채로 합니다. */
+static bool
+file_shared_swap_out (struct page *page) {
+	struct shared_page *sp = page->file.shared;
+	struct frame *frame = page->frame;
+	enum intr_level old_level;
+	struct list_elem *e;
+	bool dirty, locked = false;
+
+	/* 기록할 일이 있으면 락 순서를 지키려고 shared_lock을 놓고 filesys_lock을
+	 * 잡은 뒤 다시 본다. 교체 대상의 dirty 비트는 그 사이 꺼지지 않는다. */
+	for (;;) {
+		lock_acquire (&shared_lock);
+		old_level = intr_disable ();
+		dirty = sp->dirty;
+		for (e = list_begin (&sp->mappers); e != list_end (&sp->mappers);
+				e = list_next (e)) {
+			struct page *m = list_entry (e, struct page, file.shared_elem);
+			dirty |= pml4_is_dirty (m->file.shared_owner->pml4, m->va);
+		}
+		if (!dirty || lock_held_by_current_thread (&filesys_lock))
+			break;
+		intr_set_level (old_level);
+		lock_release (&shared_lock);
+		locked = mmap_lock_filesys ();
+	}
+
+	for (e = list_begin (&sp->mappers); e != list_end (&sp->mappers);
+			e = list_next (e)) {
+		struct page *m = list_entry (e, struct page, file.shared_elem);
+
+		pml4_clear_page (m->file.shared_owner->pml4, m->va);
+		m->frame = NULL;
+	}
+	intr_set_level (old_level);
+
+	/* 이제 어느 매퍼도 이 프레임을 가리키지 않는다. 매퍼가 떨어져 나가
+	 * 해제될 수 있으므로 교체 경로가 기록 뒤 페이지를 건드리지 않게 한다. */
+	sp->dirty = false;
+	sp->frame = NULL;
+	sp->writing = dirty;
+	frame->page = NULL;
+	lock_release (&shared_lock);
+
+	if (dirty) {
+		mmap_write_back (sp->desc->file, frame->kva, sp->read_bytes, sp->ofs);
+		lock_acquire (&shared_lock);
+		sp->writing = false;
+		cond_broadcast (&shared_written, &shared_lock);
+		lock_release (&shared_lock);
+	}
+	mmap_unlock_filesys (locked);
+	return true;
+}
+
+/* 공유 매핑 페이지 PAGE를 공유 프레임에서 떼어냅니다. 마지막 매퍼였다면
+ * 누군가 수정한 경우에만 한 번 write-back 하고 프레임을 해제합니다.
+ * 교체 경로와 같은 순서로 frame_lock을 먼저 잡고, 교체 경로가 이 항목을
+ * 기록하는 중이면 끝날 때까지 기다립니다. write-back은 두 락을 모두 놓고
+ * 하며, 그동안 항목은 writing이 켜진 채 인덱스에 남아 같은 곳을 새로
+ * 매핑하는 프로세스가 기록 전의 파일을 읽지 않게 합니다. */
+static void
+file_detach_shared (struct page *page) {
+	struct shared_page *sp = page->file.shared;
+	struct thread *curr = thread_current ();
+	struct frame *frame;
+	bool last, dirty = false;
+
+	lock_acquire (&frame_lock);
+	vm_frame_settle (page);
+	lock_acquire (&shared_lock);
+	while (sp->writing) {
+		lock_release (&frame_lock);
+		cond_wait (&shared_written, &shared_lock);
+		lock_release (&shared_lock);
+		lock_acquire (&frame_lock);
+		vm_frame_settle (page);
+		lock_acquire (&shared_lock);
+	}
+
+	frame = sp->frame;
+	if (frame != NULL) {
+		sp->dirty |= pml4_is_dirty (curr->pml4, page->va);
+		pml4_clear_page (curr->pml4, page->va);
+	}
+	list_remove (&page->file.shared_elem);
+	page->frame = NULL;
+	page->file.shared = NULL;
+
+	last = --sp->ref_cnt == 0;
+	if (last) {
+		if (frame != NULL)
+			list_remove (&frame->frame_elem);
+		dirty = frame != NULL && sp->dirty;
+		if (dirty)
+			sp->writing = true;
+		else
+			hash_delete (&shared_pages, &sp->elem);
+	} else if (frame != NULL && frame->page == page) {
+		/* 프레임의 역참조가 남아 있는 매퍼와 그 프로세스를 가리키도록 옮긴다. */
+		struct page *next = list_entry (list_front (&sp->mappers),
+				struct page, file.shared_elem);
+		frame->page = next;
+		frame->owner = next->file.shared_owner;
+	}
+	lock_release (&shared_lock);
+	lock_release (&frame_lock);
+
+	if (dirty) {
+		off_t written = mmap_write_back (sp->desc->file, frame->kva,
+				sp->read_bytes, sp->ofs);
+
+		lock_acquire (&frame_lock);
+		curr->mstat.writeback_bytes += written;
+		lock_release (&frame_lock);
+
+		lock_acquire (&shared_lock);
+		hash_delete (&shared_pages, &sp->elem);
+		sp->writing = false;
+		cond_broadcast (&shared_written, &shared_lock);
+		lock_release (&shared_lock);
+	}
+
+	if (last) {
+		if (frame != NULL) {
+			palloc_free_page (frame->kva);
+			free (frame);
+		}
+		mmap_desc_put (sp->desc);
+		free (sp);
+	}
+}
+
+/* 개인(private) 매핑 페이지의 첫 폴트 때 uninit_initialize()가 부르는
+ * initializer. 매핑 기술자 AUX와 페이지 인덱스로 읽을 위치를 계산합니다. */
+bool
+lazy_load_mmap (struct page *page, void *aux) {
+	struct mmap_desc *desc = aux;
+	size_t idx = page->file.idx;
+	size_t read_bytes = mmap_page_read_bytes (desc, idx);
+	void *kva = page->frame->kva;
+
+	if (file_read_at (desc->file, kva, read_bytes, mmap_page_ofs (desc, idx))
+			!= (off_t) read_bytes)
+		return false;
+	memset (kva + read_bytes, 0, PGSIZE - read_bytes);
+	return true;
 }
 
 /* 파일 기반 페이지를 파괴합니다. PAGE는 호출자가 해제합니다. */
 void
 file_backed_destroy (struct page *page) {	
 
-	struct frame *target_frame = page->frame;
+	struct frame *target_frame;
+	bool dirty = false;
     struct thread *curr = thread_current();
-    struct aux *aux = page->file.aux;
+    struct mmap_desc *desc = page->file.desc;
+	size_t idx = page->file.idx;
+
+	/* 공유 매핑은 프레임을 다른 매퍼와 함께 쓰므로 따로 처리 */
+	if (page->file.shared != NULL)
+	{
+		file_detach_shared (page);
+		mmap_desc_put(desc);
+		return;
+	}
+
+	/* 교체 경로와 겹치지 않도록 frame_lock 아래에서 프레임을 frame table에서
+	 * 빼고 매핑을 지운다. write-back은 frame_lock을 놓은 뒤 한다. */
+	lock_acquire(&frame_lock);
+	target_frame = vm_frame_settle(page);
+	if(target_frame != NULL)
+	{
+		dirty = pml4_is_dirty(curr->pml4, page->va);
+		list_remove(&target_frame->frame_elem);
+		pml4_clear_page(curr->pml4, page->va);
+		page->frame = NULL;
+	}
+	lock_release(&frame_lock);
 
-    if(target_frame != NULL)
-    {
+	if(target_frame != NULL)
+	{
 		/* 파일이 수정된 경우 write-back */
-		if (pml4_is_dirty(curr->pml4, page->va)) 
-        {
-            file_write_at(aux->file, page->va, aux->page_read_bytes, aux->ofs);
-            pml4_set_dirty(curr->pml4, page->va, false);
-        }
+		if (dirty)
+		{
+			off_t written = mmap_write_back(desc->file, target_frame->kva,
+					mmap_page_read_bytes(desc, idx), mmap_page_ofs(desc, idx));
+
+			lock_acquire(&frame_lock);
+			curr->mstat.writeback_bytes += written;
+			lock_release(&frame_lock);
+		}
 
 		/* 자원 해제 */
-        list_remove(&target_frame->frame_elem);
-        pml4_clear_page(curr->pml4, page->va);
-        palloc_free_page(target_frame->kva);
-        free(target_frame);
-        page->frame = NULL;
-    }		
+		palloc_free_page(target_frame->kva);
+		free(target_frame);
+	}
+
+	mmap_desc_put(desc);
 }
 
-/* mmap을 수행합니다. */
+/* 익명 mmap을 수행합니다. 페이지는 첫 접근 시 0으로 채워지는
+ * VM_ANON | VM_MARKER_1 페이지이며, 매핑 시작 주소를 aux로 기억해
+ * munmap 때 같은 매핑의 페이지를 찾는 데 씁니다. */
+static void *
+do_mmap_anon (void *addr, size_t length, int writable) {
+	struct thread *curr = thread_current();
+	uint8_t *start = addr;
+	uint8_t *end = start + ROUND_UP(length, PGSIZE);
+	uint8_t *upage;
+
+	if (end < start || !is_user_vaddr(end - 1))
+		return NULL;
+
+	/* 구간 전체가 비어 있어야 한다. */
+	for (upage = start; upage < end; upage += PGSIZE)
+		if (spt_find_page(&curr->spt, upage) != NULL)
+			return NULL;
+
+	for (upage = start; upage < end; upage += PGSIZE)
+		if (!vm_alloc_page_with_initializer(VM_ANON | VM_MARKER_1, upage,
+					writable, NULL, start))
+		{
+			/* 이미 넣은 이 매핑의 페이지를 되돌린다. */
+			while (upage > start)
+			{
+				upage -= PGSIZE;
+				spt_remove_page(&curr->spt, spt_find_page(&curr->spt, upage));
+			}
+			return NULL;
+		}
+
+	return start;
+}
+
+/* mmap을 수행합니다. FILE이 NULL이면 익명 매핑을 만듭니다.
+ * WRITABLE에 MAP_SHARED가 함께 들어 있으면 공유 매핑을 만듭니다. */
 void *
 do_mmap (void *addr, size_t length, int writable, struct file *file, off_t ofs) {
+
+	bool shared = (writable & MAP_SHARED) != 0;
+	writable &= ~MAP_SHARED;
+
+	if (file == NULL)
+		return do_mmap_anon(addr, length, writable);
 	
-	void *start = addr;
-	uint32_t read_bytes = length < (file_length(file) - ofs) ? length : (file_length(file) - ofs);
-	
-	while (read_bytes > 0) {
-		/* 이 페이지를 채울 양을 계산한다.
-		 * PAGE_READ_BYTES 바이트를 파일에서 읽고
-		 * 나머지는 PAGE_ZERO_BYTES 바이트를 0으로 채운다. */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE; /* 한 턴에 최대 1 페이지만큼만 read */
-		size_t page_zero_bytes = PGSIZE - page_read_bytes; /* 0으로 채운 패딩 사이즈는 4KB - page_read_bytes */		
-
-		/* aux 메모리 할당 후 필드 초기화 */
-		struct aux *aux = malloc(sizeof(struct aux));
-		if(aux == NULL)
-			return NULL;
+	struct mmap_desc *desc = malloc(sizeof *desc);
+	if (desc == NULL)
+		return NULL;
 
-		aux->file = file_reopen(file); 
-		aux->ofs = ofs;
-		aux->page_read_bytes = page_read_bytes;
-		aux->page_zero_bytes = page_zero_bytes;		
+	/* 매핑 전체가 파일을 한 번만 reopen 해서 함께 쓴다. */
+	desc->file = file_reopen(file);
+	if (desc->file == NULL)
+	{
+		free(desc);
+		return NULL;
+	}
+	desc->base = addr;
+	desc->ofs = ofs;
+	desc->read_bytes = length < (size_t) (file_length(file) - ofs) ? length : (size_t) (file_length(file) - ofs);
+	desc->ref_cnt = 1;              /* 페이지를 만드는 동안 잡아 두는 참조 */
 
-		if (!vm_alloc_page_with_initializer (VM_FILE, addr,
-					writable, lazy_load_segment, aux))
-			return NULL;
+	/* 파일에서 읽을 부분이 있는 페이지만 매핑한다. */
+	size_t page_cnt = DIV_ROUND_UP(desc->read_bytes, PGSIZE);
+	size_t idx;
+	desc->length = page_cnt * PGSIZE;
+	for (idx = 0; idx < page_cnt; idx++)
+	{
+		/* 페이지마다 기술자 참조를 하나씩 넘긴다.
+		 * 공유 매핑 페이지는 VM_MARKER_1로 표시하고 공유 인덱스를 거쳐 올린다. */
+		if (!vm_alloc_page_with_initializer (shared ? VM_FILE | VM_MARKER_1 : VM_FILE,
+					addr + idx * PGSIZE, writable,
+					shared ? lazy_load_shared : lazy_load_mmap, mmap_desc_get(desc)))
+		{
+			/* 넘기지 못한 참조와 만드는 동안 잡은 참조를 놓는다. 이미 넣은
+			 * 페이지는 제거하면 uninit_destroy()가 제 참조를 놓는다. */
+			struct thread *curr = thread_current();
 
-		/* 다음 주소로 이동. */
-		read_bytes -= page_read_bytes;		
-		ofs += page_read_bytes; /* 오프셋 업데이트 */ 
-		addr += PGSIZE;
+			mmap_desc_put(desc);
+			while (idx-- > 0)
+				spt_remove_page(&curr->spt, spt_find_page(&curr->spt, addr + idx * PGSIZE));
+			mmap_desc_put(desc);
+			return NULL;
+		}
 	}
-	return start;
+	mmap_desc_put(desc);
+	return addr;
+}
+
+/* PAGE가 파일 매핑에 속하면 그 매핑 기술자를, 아니면 NULL을 반환합니다.
+ * 아직 한 번도 접근하지 않은 uninit 페이지도 처리합니다. */
+static struct mmap_desc *
+page_mmap_desc (struct page *page) {
+	if (page->operations->type == VM_FILE)
+		return page->file.desc;
+	if (page->operations->type == VM_UNINIT && VM_TYPE(page->uninit.type) == VM_FILE)
+		return (struct mmap_desc *) page->uninit.aux;
+	return NULL;
 }
 
 /* munmap을 수행합니다. */
@@ -120,29 +708,95 @@ do_munmap (void *addr) {
 
 	struct page *page = spt_find_page(&curr->spt, addr);
 
-	struct file *file = page->file.aux->file;
-	
 	if (page == NULL)
-		return NULL;
-	
-	while (page->operations->type == VM_FILE && file == page->file.aux->file)
-	{
-		struct aux *aux = page->file.aux;
+		return;
 
-		if (pml4_is_dirty(curr->pml4, page->va)) 
+	/* 익명 매핑이면 같은 매핑에 속한 페이지를 모두 SPT에서 제거한다. */
+	void *base = anon_mmap_base(page);
+	if (base != NULL)
+	{
+		while (page != NULL && anon_mmap_base(page) == base)
 		{
-			file_write_at(aux->file, page->va, aux->page_read_bytes, aux->ofs);
-			pml4_set_dirty(curr->pml4, page->va, false);
+			spt_remove_page(&curr->spt, page);
+			addr += PGSIZE;
+			page = spt_find_page(&curr->spt, addr);
 		}
+		return;
+	}
 
-		pml4_clear_page(curr->pml4, page->va);
-		// spt_remove_page(&curr->spt, page);
-		// hash_delete(&curr->spt.hash_table, &page->hash_elem);		
+	/* 파일 매핑이면 기술자에 기록된 매핑 전체를 SPT에서 제거한다.
+	 * 페이지 파괴 과정에서 dirty 페이지는 write-back 되고 기술자 참조가 풀린다. */
+	struct mmap_desc *desc = page_mmap_desc(page);
+	if (desc == NULL || desc->base != addr)
+		return;
 
-		addr += PGSIZE;
-		page = spt_find_page(&curr->spt, addr);
+	uint8_t *upage = desc->base;
+	uint8_t *end = upage + desc->length;
 
-		if(page == NULL)
-			break;
+	for (; upage < end; upage += PGSIZE)
+	{
+		page = spt_find_page(&curr->spt, upage);
+		if (page != NULL && page_mmap_desc(page) == desc)
+			spt_remove_page(&curr->spt, page);
+	}
+}
+
+/* 개인 매핑 페이지 정렬 기준: 매핑 기술자, 그 안의 페이지 인덱스 순 */
+static bool
+flush_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct page *a = list_entry (a_, struct page, hash_elem.list_elem);
+	const struct page *b = list_entry (b_, struct page, hash_elem.list_elem);
+	if (a->file.desc != b->file.desc)
+		return a->file.desc < b->file.desc;
+	return a->file.idx < b->file.idx;
+}
+
+/* 프로세스 종료 시 supplemental_page_table_kill()이 부릅니다.
+ * PAGES(hash_elem.list_elem으로 엮인 페이지 목록)에서 수정된 개인 매핑
+ * 페이지를 골라 매핑별로 모으고, 인덱스가 이어지는 구간마다 file_write_at을
+ * 한 번만 호출합니다. 구간은 사용자 가상 주소에서도 연속이므로 현재 pml4를
+ * 통해 그대로 기록합니다. 기록한 페이지는 dirty 비트를 지워 이후 destroy에서
+ * 다시 쓰지 않도록 합니다. */
+void
+file_backed_flush (struct list *pages) {
+	struct thread *curr = thread_current ();
+	struct list dirty;
+	struct list_elem *e, *next;
+
+	list_init (&dirty);
+	for (e = list_begin (pages); e != list_end (pages); e = next) {
+		struct page *page = list_entry (e, struct page, hash_elem.list_elem);
+
+		next = list_next (e);
+		if (page->operations->type == VM_FILE && page->file.shared == NULL
+				&& page->frame != NULL && pml4_is_dirty (curr->pml4, page->va)) {
+			list_remove (e);
+			list_push_back (&dirty, e);
+		}
 	}
+	list_sort (&dirty, flush_less, NULL);
+
+	e = list_begin (&dirty);
+	while (e != list_end (&dirty)) {
+		struct page *first = list_entry (e, struct page, hash_elem.list_elem);
+		struct mmap_desc *desc = first->file.desc;
+		size_t cnt = 0, skip, bytes;
+
+		/* 같은 매핑에서 인덱스가 이어지는 동안 구간을 늘린다. */
+		for (; e != list_end (&dirty); e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, hash_elem.list_elem);
+			if (page->file.desc != desc || page->file.idx != first->file.idx + cnt)
+				break;
+			pml4_set_dirty (curr->pml4, page->va, false);
+			cnt++;
+		}
+
+		skip = first->file.idx * PGSIZE;
+		bytes = desc->read_bytes - skip < cnt * PGSIZE ? desc->read_bytes - skip : cnt * PGSIZE;
+		curr->mstat.writeback_bytes +=
+			mmap_write_back (desc->file, first->va, bytes, mmap_page_ofs (desc, first->file.idx));
+	}
+
+	list_splice (list_end (pages), list_begin (&dirty), list_end (&dirty));
 }
@@ -0,0 +1,173 @@
+/* prefetch.c: 실행 파일 세그먼트의 적응형 선적재(eager loading)입니다.
+ *
+ * load_segment()는 원래 모든 페이지를 지연 적재로 등록하므로, 이미지 전체를
+ * 건드리는 작은 프로그램도 시작할 때 페이지마다 폴트를 한 번씩 겪습니다.
+ * 여기서는 실행 파일(inode)마다 프로파일을 두고, 프로세스가 끝날 때 세그먼트
+ * 페이지 가운데 실제로 올라왔던 페이지를 "hot"으로 기록합니다. 다음 실행의
+ * load() 때 hot 페이지와, 프로파일과 상관없이 크기가 작은 실행 파일에서
+ * 파일 내용이 있는 페이지를 바로 올리고, 나머지는 그대로 지연 적재합니다.
+ * 0으로 채우는 BSS 페이지는 읽을 것이 없으므로 hot일 때만 올립니다.
+ *
+ * 프로파일은 첫 PT_LOAD 세그먼트의 시작 주소를 기준으로 한 페이지 인덱스
+ * 비트맵이며, PREFETCH_MAX개까지만 두고 실행 중인 프로세스가 쓰고 있지
+ * 않은 것 가운데 가장 오래 쓰지 않은 것부터 재사용합니다. */
+
+#include "vm/prefetch.h"
+#include <bitmap.h>
+#include <list.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* 이 크기 이하의 실행 파일은 프로파일 없이 전부 선적재한다. */
+#define PREFETCH_SMALL_BYTES (64 * 1024)
+/* 프로파일 하나가 다루는 페이지 수 (기준 주소부터 4 MiB) */
+#define PREFETCH_PAGES 1024
+/* 동시에 유지하는 프로파일 수 */
+#define PREFETCH_MAX 32
+
+/* 실행 파일 하나의 프로파일 */
+struct exec_profile {
+	disk_sector_t inumber;      /* 실행 파일의 inode 번호 */
+	void *base;                 /* 페이지 인덱스의 기준 주소 */
+	bool small;                 /* 크기가 작아 전부 선적재하는지 */
+	struct bitmap *segment;     /* load_segment()가 등록한 페이지 */
+	struct bitmap *hot;         /* 지난 실행에서 올라왔던 페이지 */
+	int users;                  /* 이 프로파일을 exec_prof로 쥔 프로세스 수 */
+	struct list_elem elem;      /* profiles 원소 (앞쪽일수록 최근에 사용) */
+};
+
+static struct list profiles;
+static struct lock prefetch_lock;
+
+void
+prefetch_init (void) {
+	list_init (&profiles);
+	lock_init (&prefetch_lock);
+}
+
+/* PROF 기준으로 UPAGE의 페이지 인덱스를 구한다. 범위 밖이면 false. */
+static bool
+profile_index (struct exec_profile *prof, void *upage, size_t *idx) {
+	if (prof->base == NULL || upage < prof->base)
+		return false;
+	*idx = ((uint8_t *) upage - (uint8_t *) prof->base) / PGSIZE;
+	return *idx < PREFETCH_PAGES;
+}
+
+/* INUMBER의 프로파일을 찾고, 없으면 새로 만들거나 아무도 쓰지 않는 것
+ * 가운데 가장 오래된 것을 재사용한다. 모두 쓰이고 있으면 NULL.
+ * 반환한 프로파일의 users를 하나 늘린다.
+ * prefetch_lock을 잡은 상태에서 호출한다. */
+static struct exec_profile *
+profile_lookup (disk_sector_t inumber) {
+	struct exec_profile *prof;
+	struct list_elem *e;
+
+	for (e = list_begin (&profiles); e != list_end (&profiles); e = list_next (e)) {
+		prof = list_entry (e, struct exec_profile, elem);
+		if (prof->inumber == inumber) {
+			list_remove (e);
+			list_push_front (&profiles, e);
+			prof->users++;
+			return prof;
+		}
+	}
+
+	if (list_size (&profiles) >= PREFETCH_MAX) {
+		/* 실행 중인 프로세스가 기록할 프로파일은 건너뛴다. */
+		for (e = list_rbegin (&profiles); e != list_rend (&profiles); e = list_prev (e))
+			if (list_entry (e, struct exec_profile, elem)->users == 0)
+				break;
+		if (e == list_rend (&profiles))
+			return NULL;
+		list_remove (e);
+		prof = list_entry (e, struct exec_profile, elem);
+	} else {
+		prof = malloc (sizeof *prof);
+		if (prof == NULL)
+			return NULL;
+		prof->segment = bitmap_create (PREFETCH_PAGES);
+		prof->hot = bitmap_create (PREFETCH_PAGES);
+		if (prof->segment == NULL || prof->hot == NULL) {
+			bitmap_destroy (prof->segment);
+			bitmap_destroy (prof->hot);
+			free (prof);
+			return NULL;
+		}
+	}
+
+	prof->inumber = inumber;
+	prof->base = NULL;
+	prof->users = 1;
+	bitmap_set_all (prof->segment, false);
+	bitmap_set_all (prof->hot, false);
+	list_push_front (&profiles, &prof->elem);
+	return prof;
+}
+
+/* load()가 실행 파일 FILE을 연 직후 호출한다. 현재 스레드가 이번 실행에서
+ * 쓸 프로파일을 정한다. */
+void
+prefetch_begin (struct file *file) {
+	struct thread *curr = thread_current ();
+
+	lock_acquire (&prefetch_lock);
+	curr->exec_prof = profile_lookup (inode_get_inumber (file_get_inode (file)));
+	if (curr->exec_prof != NULL)
+		curr->exec_prof->small = file_length (file) <= PREFETCH_SMALL_BYTES;
+	lock_release (&prefetch_lock);
+}
+
+/* load_segment()가 UPAGE를 등록한 뒤 호출한다. FILE_BACKED는 파일에서 읽을
+ * 내용이 있는 페이지인지를 뜻한다. UPAGE를 세그먼트 페이지로 기록하고,
+ * 바로 올려야 하면 true를 반환한다. */
+bool
+prefetch_is_hot (void *upage, bool file_backed) {
+	struct exec_profile *prof = thread_current ()->exec_prof;
+	bool hot = false;
+	size_t idx;
+
+	if (prof == NULL)
+		return false;
+
+	lock_acquire (&prefetch_lock);
+	if (prof->base == NULL)
+		prof->base = upage;
+	if (profile_index (prof, upage, &idx)) {
+		bitmap_mark (prof->segment, idx);
+		hot = (prof->small && file_backed) || bitmap_test (prof->hot, idx);
+	}
+	lock_release (&prefetch_lock);
+	return hot;
+}
+
+/* 프로세스 T의 이미지를 정리하기 직전(process_cleanup)에 호출한다. 세그먼트
+ * 페이지 가운데 한 번이라도 올라왔던 페이지를 다음 실행을 위한 hot 집합으로
+ * 기록한다. 교체되어 지금은 나가 있는 페이지도 uninit이 아니면 포함한다. */
+void
+prefetch_record (struct thread *t) {
+	struct exec_profile *prof = t->exec_prof;
+	size_t idx;
+
+	if (prof == NULL)
+		return;
+	t->exec_prof = NULL;
+
+	lock_acquire (&prefetch_lock);
+	for (idx = 0; idx < PREFETCH_PAGES; idx++) {
+		struct page *page;
+
+		if (!bitmap_test (prof->segment, idx))
+			continue;
+		page = spt_find_page (&t->spt, (uint8_t *) prof->base + idx * PGSIZE);
+		bitmap_set (prof->hot, idx,
+				page != NULL && VM_TYPE (page->operations->type) != VM_UNINIT);
+	}
+	prof->users--;
+	lock_release (&prefetch_lock);
+}
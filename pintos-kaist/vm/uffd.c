@@ -0,0 +1,373 @@
+/* uffd.c: 사용자 공간 페이지 폴트 처리(userfaultfd 방식)의 구현입니다.
+ *
+ * uffd_register()로 등록한 구간의 페이지는 익명 페이지로 SPT에 들어가지만
+ * 첫 폴트 때 커널이 내용을 채우지 않습니다. 대신 폴트를 uffd 객체의
+ * 대기열에 넣고 폴트를 낸 스레드를 재웁니다. 핸들러 프로세스는 uffd_read()로
+ * 폴트를 받아 uffd_copy()로 페이지 내용을 넣어 주고, 그러면 폴트를 낸
+ * 스레드가 깨어나 실행을 이어갑니다.
+ *
+ * 폴트가 난 페이지의 프레임은 이미 할당되어 매핑된 상태이므로, 핸들러는
+ * 다른 프로세스에서도 유효한 프레임의 커널 가상 주소(kva)로 바로 복사합니다.
+ * 구간을 등록한 프로세스(owner)를 제외하고 uffd를 열고 있는 핸들러가 없으면
+ * 폴트는 실패로 처리되어 해당 프로세스가 종료됩니다. */
+
+#include "vm/uffd.h"
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* uffd 객체 */
+struct uffd {
+	struct condition fault_cond;    /* unread에 폴트가 들어오거나 owner가 떠나면 신호 */
+	struct list unread;             /* 아직 uffd_read()로 전달하지 않은 폴트 */
+	struct list reported;           /* 전달했지만 아직 채워지지 않은 폴트 */
+	struct thread *owner;           /* 구간을 등록한 프로세스 */
+	bool released;                  /* owner가 떠나 더 이상 폴트가 오지 않음 */
+	int fd_cnt;                     /* 이 객체를 가리키는 디스크립터 수 */
+	struct list_elem elem;          /* uffd_list 원소 */
+};
+
+/* 처리를 기다리는 폴트 하나. 폴트를 낸 스레드의 커널 스택에 놓입니다. */
+struct uffd_fault {
+	void *va;                       /* 폴트가 난 페이지 */
+	void *kva;                      /* 그 페이지에 매핑된 프레임 */
+	tid_t tid;
+	bool resolved;                  /* uffd_copy()로 채워졌는지 여부 */
+	struct semaphore done;
+	struct list_elem elem;
+};
+
+/* 살아 있는 모든 uffd 객체와, 이들의 상태를 보호하는 락 */
+static struct list uffd_list;
+static struct lock uffd_lock;
+
+static bool uffd_fault (struct page *page, void *aux);
+
+void
+uffd_init (void)
+{
+	list_init (&uffd_list);
+	lock_init (&uffd_lock);
+}
+
+/* 현재 스레드의 디스크립터 FD가 가리키는 uffd를 반환합니다. */
+static struct uffd *
+uffd_lookup (int fd)
+{
+	if (fd < UFFD_FD_BASE || fd >= UFFD_FD_BASE + UFFD_MAX)
+		return NULL;
+	return thread_current ()->uffds[fd - UFFD_FD_BASE];
+}
+
+/* owner를 제외하고 UFFD를 열고 있는 디스크립터, 즉 폴트를 처리해 줄 수
+ * 있는 핸들러 쪽 디스크립터 수를 반환합니다. uffd_lock을 잡고 호출합니다. */
+static int
+uffd_handler_cnt (struct uffd *uffd)
+{
+	int cnt = uffd->fd_cnt;
+
+	if (uffd->owner != NULL)
+		for (int i = 0; i < UFFD_MAX; i++)
+			if (uffd->owner->uffds[i] == uffd)
+				cnt--;
+	return cnt;
+}
+
+/* 대기 중인 폴트를 모두 실패로 깨웁니다. uffd_lock을 잡고 호출합니다. */
+static void
+uffd_fail_pending (struct uffd *uffd)
+{
+	struct list *lists[] = { &uffd->unread, &uffd->reported };
+
+	for (int i = 0; i < 2; i++)
+		while (!list_empty (lists[i]))
+		{
+			struct uffd_fault *f = list_entry (list_pop_front (lists[i]),
+											   struct uffd_fault, elem);
+			f->resolved = false;
+			sema_up (&f->done);
+		}
+}
+
+/* 더 이상 참조가 없으면 UFFD를 해제합니다. uffd_lock을 잡고 호출합니다. */
+static void
+uffd_put (struct uffd *uffd)
+{
+	if (uffd->fd_cnt == 0 && uffd->owner == NULL)
+	{
+		list_remove (&uffd->elem);
+		free (uffd);
+	}
+}
+
+/* 새 uffd를 만들고 디스크립터를 반환합니다. 실패 시 -1을 반환합니다. */
+int
+uffd_create (void)
+{
+	struct thread *curr = thread_current ();
+	struct uffd *uffd;
+	int idx;
+
+	for (idx = 0; idx < UFFD_MAX; idx++)
+		if (curr->uffds[idx] == NULL)
+			break;
+	if (idx == UFFD_MAX)
+		return -1;
+
+	uffd = malloc (sizeof *uffd);
+	if (uffd == NULL)
+		return -1;
+	cond_init (&uffd->fault_cond);
+	list_init (&uffd->unread);
+	list_init (&uffd->reported);
+	uffd->owner = NULL;
+	uffd->released = false;
+	uffd->fd_cnt = 1;
+
+	lock_acquire (&uffd_lock);
+	list_push_back (&uffd_list, &uffd->elem);
+	curr->uffds[idx] = uffd;
+	lock_release (&uffd_lock);
+
+	return UFFD_FD_BASE + idx;
+}
+
+/* 현재 프로세스의 [ADDR, ADDR + LENGTH) 구간을 uffd FD에 등록합니다.
+ * 구간의 페이지는 쓰기 가능한 익명 페이지로 SPT에 추가되며, 첫 폴트는
+ * 핸들러에게 전달됩니다. 구간은 페이지 정렬되어 있어야 하고 기존 페이지와
+ * 겹치면 안 됩니다. 한 uffd에는 한 프로세스만 구간을 등록할 수 있습니다. */
+bool
+uffd_register (int fd, void *addr, size_t length)
+{
+	struct thread *curr = thread_current ();
+	struct uffd *uffd = uffd_lookup (fd);
+	uint8_t *start = addr;
+	uint8_t *end = start + length;
+	uint8_t *upage;
+	bool ok;
+
+	if (uffd == NULL || start == NULL || pg_ofs (start) != 0 || length == 0)
+		return false;
+	if (end < start || !is_user_vaddr (end - 1))
+		return false;
+
+	lock_acquire (&uffd_lock);
+	ok = uffd->owner == NULL || uffd->owner == curr;
+	lock_release (&uffd_lock);
+	if (!ok)
+		return false;
+
+	for (upage = start; upage < end; upage += PGSIZE)
+		if (spt_find_page (&curr->spt, upage) != NULL)
+			return false;
+
+	for (upage = start; upage < end; upage += PGSIZE)
+		if (!vm_alloc_page_with_initializer (VM_ANON, upage, true, uffd_fault, uffd))
+		{
+			/* 이미 넣은 페이지를 빼서 등록하지 않은 uffd를 가리키지 않게 한다. */
+			while (upage > start)
+			{
+				upage -= PGSIZE;
+				spt_remove_page (&curr->spt, spt_find_page (&curr->spt, upage));
+			}
+			return false;
+		}
+
+	lock_acquire (&uffd_lock);
+	uffd->owner = curr;
+	uffd->released = false;
+	lock_release (&uffd_lock);
+	return true;
+}
+
+/* uffd FD로 보고된 폴트 하나를 MSG에 담아 반환합니다.
+ * 보고할 폴트가 없으면 생길 때까지 기다리며, 구간을 등록한 프로세스가
+ * 떠나 더 이상 폴트가 오지 않으면 false를 반환합니다. */
+bool
+uffd_read (int fd, struct uffd_msg *msg)
+{
+	struct uffd *uffd = uffd_lookup (fd);
+	struct uffd_msg m;
+
+	if (uffd == NULL)
+		return false;
+
+	lock_acquire (&uffd_lock);
+	while (list_empty (&uffd->unread))
+	{
+		if (uffd->owner == NULL && uffd->released)
+		{
+			lock_release (&uffd_lock);
+			return false;
+		}
+		cond_wait (&uffd->fault_cond, &uffd_lock);
+	}
+
+	struct uffd_fault *f = list_entry (list_pop_front (&uffd->unread),
+									   struct uffd_fault, elem);
+	list_push_back (&uffd->reported, &f->elem);
+	m.addr = f->va;
+	m.tid = f->tid;
+	lock_release (&uffd_lock);
+
+	/* 사용자 버퍼에 쓰다가 폴트가 날 수 있으므로 락을 놓은 뒤에 복사한다. */
+	*msg = m;
+	return true;
+}
+
+/* 폴트가 나 있는 페이지 DST에 SRC의 LENGTH 바이트를 채우고 폴트를 낸
+ * 스레드를 깨웁니다. LENGTH는 1 이상 PGSIZE 이하이며 나머지는 0으로 남습니다.
+ * DST에 처리를 기다리는 폴트가 없으면 false를 반환합니다. */
+bool
+uffd_copy (int fd, void *dst, const void *src, size_t length)
+{
+	struct uffd *uffd = uffd_lookup (fd);
+	struct uffd_fault *found = NULL;
+	struct list *lists[2];
+
+	if (uffd == NULL || pg_ofs (dst) != 0 || length == 0 || length > PGSIZE)
+		return false;
+
+	lock_acquire (&uffd_lock);
+	lists[0] = &uffd->reported;
+	lists[1] = &uffd->unread;
+	for (int i = 0; i < 2 && found == NULL; i++)
+		for (struct list_elem *e = list_begin (lists[i]); e != list_end (lists[i]);
+			 e = list_next (e))
+		{
+			struct uffd_fault *f = list_entry (e, struct uffd_fault, elem);
+			if (f->va == dst)
+			{
+				list_remove (e);
+				found = f;
+				break;
+			}
+		}
+	lock_release (&uffd_lock);
+
+	if (found == NULL)
+		return false;
+
+	/* 폴트를 낸 스레드는 잠들어 있으므로 FOUND와 프레임은 계속 유효하다. */
+	memcpy (found->kva, src, length);
+	found->resolved = true;
+	sema_up (&found->done);
+	return true;
+}
+
+/* 현재 스레드의 uffd 디스크립터 FD를 닫습니다. 핸들러가 하나도 남지 않으면
+ * 처리를 기다리던 폴트는 모두 실패합니다. */
+bool
+uffd_close (int fd)
+{
+	struct uffd *uffd = uffd_lookup (fd);
+
+	if (uffd == NULL)
+		return false;
+
+	lock_acquire (&uffd_lock);
+	thread_current ()->uffds[fd - UFFD_FD_BASE] = NULL;
+	uffd->fd_cnt--;
+	if (uffd_handler_cnt (uffd) == 0)
+		uffd_fail_pending (uffd);
+	cond_broadcast (&uffd->fault_cond, &uffd_lock);
+	uffd_put (uffd);
+	lock_release (&uffd_lock);
+	return true;
+}
+
+/* 현재 스레드의 uffd 디스크립터를 모두 닫습니다. */
+void
+uffd_close_all (void)
+{
+	for (int i = 0; i < UFFD_MAX; i++)
+		if (thread_current ()->uffds[i] != NULL)
+			uffd_close (UFFD_FD_BASE + i);
+}
+
+/* fork 시 부모의 uffd 디스크립터를 자식에게 복제합니다.
+ * 등록한 구간은 자식에게 넘어가지 않으며, 자식의 SPT에 복사된 구간의
+ * 페이지는 폴트 시 0으로 채워집니다. */
+void
+uffd_fork (struct thread *child, struct thread *parent)
+{
+	lock_acquire (&uffd_lock);
+	for (int i = 0; i < UFFD_MAX; i++)
+		if (parent->uffds[i] != NULL)
+		{
+			child->uffds[i] = parent->uffds[i];
+			child->uffds[i]->fd_cnt++;
+		}
+	lock_release (&uffd_lock);
+}
+
+/* T가 등록한 구간을 모두 해제합니다. T의 주소 공간이 사라질 때
+ * (exec, exit) 호출합니다. uffd_read()에서 기다리는 핸들러를 깨워
+ * 더 올 폴트가 없음을 알립니다. */
+void
+uffd_release (struct thread *t)
+{
+	struct list_elem *e, *next;
+
+	lock_acquire (&uffd_lock);
+	for (e = list_begin (&uffd_list); e != list_end (&uffd_list); e = next)
+	{
+		struct uffd *uffd = list_entry (e, struct uffd, elem);
+		next = list_next (e);
+		if (uffd->owner == t)
+		{
+			uffd->owner = NULL;
+			uffd->released = true;
+			cond_broadcast (&uffd->fault_cond, &uffd_lock);
+			uffd_put (uffd);
+		}
+	}
+	lock_release (&uffd_lock);
+}
+
+/* 등록한 구간의 페이지에 첫 폴트가 났을 때 uninit_initialize()가 부르는
+ * initializer입니다. 폴트를 핸들러에게 보고하고 채워질 때까지 기다립니다. */
+static bool
+uffd_fault (struct page *page, void *aux)
+{
+	struct thread *curr = thread_current ();
+	struct uffd *uffd = NULL;
+	struct uffd_fault fault;
+
+	lock_acquire (&uffd_lock);
+	/* fork로 복사된 자식처럼 AUX가 이미 해제되었을 수 있으므로
+	 * 살아 있는 uffd인지 먼저 확인한다. */
+	for (struct list_elem *e = list_begin (&uffd_list); e != list_end (&uffd_list);
+		 e = list_next (e))
+		if (list_entry (e, struct uffd, elem) == aux)
+			uffd = aux;
+
+	/* 구간을 등록한 프로세스가 아니면 0으로 채운 페이지로 둔다. */
+	if (uffd == NULL || uffd->owner != curr)
+	{
+		lock_release (&uffd_lock);
+		return true;
+	}
+
+	/* 폴트를 처리해 줄 핸들러가 없다. */
+	if (uffd_handler_cnt (uffd) == 0)
+	{
+		lock_release (&uffd_lock);
+		return false;
+	}
+
+	fault.va = page->va;
+	fault.kva = page->frame->kva;
+	fault.tid = curr->tid;
+	fault.resolved = false;
+	sema_init (&fault.done, 0);
+	list_push_back (&uffd->unread, &fault.elem);
+	cond_signal (&uffd->fault_cond, &uffd_lock);
+	lock_release (&uffd_lock);
+
+	sema_down (&fault.done);
+	return fault.resolved;
+}
@@ -61,7 +61,11 @@ uninit_initialize (struct page *page, void *kva) {
  * PAGE는 호출자가 해제합니다. */
 static void
 uninit_destroy (struct page *page) {
-	struct uninit_page *uninit UNUSED = &page->uninit;
+	struct uninit_page *uninit = &page->uninit;
+
+	/* 파일 매핑 페이지는 매핑 기술자 참조를 하나 잡고 있다. */
+	if (VM_TYPE (uninit->type) == VM_FILE)
+		mmap_desc_put ((struct mmap_desc *) uninit->aux);
 
 	// if (uninit->aux != NULL) {
 	// 	free(uninit->aux);
@@ -1,11 +1,40 @@
 /* vm.c: 가상 메모리 객체를 위한 일반적인 인터페이스입니다. */
 /* test */
+#include <bitmap.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 #include "threads/malloc.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "vm/uffd.h"
+#include "vm/prefetch.h"
+#include "userprog/syscall.h"
+#include "devices/timer.h"
 
 /* Global frame table. */
 struct list frame_table;
+struct lock frame_lock;
+
+/* 세탁 목록. 교체 시계가 만난 더러운 프레임을 여기에 넘기면 세탁 스레드가
+ * 묶음 단위로 내용을 기록해 깨끗하게 만든다. frame_lock이 보호한다. */
+static struct list laundry_list;
+static size_t laundry_cnt;              /* 목록에 있거나 기록 중인 프레임 수 */
+static struct condition laundry_cond;   /* 세탁할 프레임이 생김 */
+static struct condition laundry_done;   /* 세탁 묶음 하나가 끝남 */
+
+/* 세탁 스레드가 한 번에 기록하는 최대 프레임 수 */
+#define LAUNDRY_BATCH 16
+/* 깨끗한 프레임이 없을 때 세탁을 기다리는 최대 횟수. 넘으면 더러운
+ * 프레임을 직접 내보낸다. */
+#define LAUNDRY_RETRY 4
+
+/* 벤치마크와 통계 출력을 위한 VM 카운터 */
+static long long fault_cnt;     /* 처리에 성공한 페이지 폴트 수 */
+static long long evict_cnt;     /* 교체된 프레임 수 */
+
+static void register_vm_stat_intr (void);
+static void laundry_writer (void *aux);
 
 /* 각 서브시스템의 초기화 코드를 호출하여
  * 가상 메모리 하위 시스템을 초기화합니다. */
@@ -13,6 +42,8 @@ void vm_init(void)
 {
 	vm_anon_init();
 	vm_file_init();
+	uffd_init();
+	prefetch_init();
 
 #ifdef EFILESYS /* For project 4 */
 	pagecache_init();
@@ -21,11 +52,107 @@ void vm_init(void)
 	/* 위의 줄은 수정하지 마세요. */
 	/* TODO: 여기에 코드를 작성하세요. */
 	/* frame table 초기화 */
-	ASSERT (&frame_table != NULL);
-	frame_table.head.prev = &frame_table.tail;
-	frame_table.head.next = &frame_table.tail;
-	frame_table.tail.prev = &frame_table.head;
-	frame_table.tail.next = &frame_table.head;
+	list_init (&frame_table);
+	lock_init (&frame_lock);
+	list_init (&laundry_list);
+	cond_init (&laundry_cond);
+	cond_init (&laundry_done);
+	thread_create ("laundry", PRI_DEFAULT, laundry_writer, NULL);
+
+	register_vm_stat_intr ();
+}
+
+/* VM 통계를 출력합니다. */
+void
+vm_print_stats (void)
+{
+	printf ("VM: %lld faults, %lld evictions\n", fault_cnt, evict_cnt);
+}
+
+static void
+inspect_vm_stat (struct intr_frame *f)
+{
+	switch (f->R.rdx)
+	{
+	case 0:
+		f->R.rax = fault_cnt;
+		break;
+	case 1:
+		f->R.rax = evict_cnt;
+		break;
+	case 2:
+		f->R.rax = timer_ticks ();
+		break;
+	case 3:
+		f->R.rax = swap_dev_mask ();
+		break;
+	default:
+		f->R.rax = 0;
+		break;
+	}
+}
+
+/* 벤치마크(tests/vm/bench)에서 커널 카운터를 읽기 위한 도구입니다.
+ * int 0x45 인터럽트를 통해 호출합니다.
+ * Input:
+ *   @RDX - 읽을 카운터 (0: 폴트 수, 1: 교체 수, 2: 타이머 틱,
+ *          3: 스왑 장치 마스크, swap_dev_mask() 참고)
+ * Output:
+ *   @RAX - 카운터 값 */
+static void
+register_vm_stat_intr (void)
+{
+	intr_register_int (0x45, 3, INTR_OFF, inspect_vm_stat, "Inspect VM Counters");
+}
+
+/* PAGE를 올리는 데 파일이나 스왑 디스크를 읽어야 하면(major 폴트) true */
+static bool
+vm_fault_is_major(struct page *page)
+{
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+		if (VM_TYPE(page->uninit.type) == VM_FILE)
+			return true;
+		return page->uninit.init == lazy_load_segment &&
+			   ((struct aux *)page->uninit.aux)->page_read_bytes > 0;
+	case VM_ANON:
+		return page->anon.swap_idx != SWAP_NONE && !page->anon.patterned;
+	default:
+		return true;
+	}
+}
+
+/* 현재 프로세스의 메모리/페이징 통계를 ST에 채웁니다.
+ * 페이지 수는 SPT를 한 번 훑어 세고, 폴트/복사/write-back 횟수는
+ * 각 경로에서 스레드의 mstat에 누적해 둔 값을 그대로 돌려줍니다. */
+bool
+vm_memstat(struct memstat *st)
+{
+	struct thread *curr = thread_current();
+	struct memstat stat = curr->mstat;
+	struct hash_iterator i;
+
+	stat.anon_pages = stat.file_pages = 0;
+	stat.uninit_pages = stat.swapped_pages = 0;
+
+	hash_first(&i, &curr->spt.hash_table);
+	while (hash_next(&i))
+	{
+		struct page *page = hash_entry(hash_cur(&i), struct page, hash_elem);
+
+		if (VM_TYPE(page->operations->type) == VM_UNINIT)
+			stat.uninit_pages++;
+		else if (page->frame == NULL)
+			stat.swapped_pages += VM_TYPE(page->operations->type) == VM_ANON;
+		else if (VM_TYPE(page->operations->type) == VM_ANON)
+			stat.anon_pages++;
+		else
+			stat.file_pages++;
+	}
+
+	memcpy(st, &stat, sizeof stat);
+	return true;
 }
 
 /* 페이지의 유형을 얻습니다. 초기화된 이후에 어떤 타입이 될지
@@ -44,8 +171,10 @@ page_get_type(struct page *page)
 }
 
 /* 헬퍼 함수들 */
-static struct frame *vm_get_victim(void);
+static struct frame *vm_get_victim(bool clean_only);
 static bool vm_do_claim_page(struct page *page);
+static bool vm_claim_pinned(struct page *page);
+static bool vm_claim_huge_page(struct page *page);
 static struct frame *vm_evict_frame(void);
 
 /* 초기화 함수를 가지고 미리 생성해 두는 페이지 객체를 만듭니다.
@@ -146,84 +275,423 @@ bool spt_insert_page(struct supplemental_page_table *spt, struct page *page)
 	return true;
 }
 
+/* PAGE를 spt에서 제거하고 해제합니다. */
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
+	hash_delete(&spt->hash_table, &page->hash_elem);
 	vm_dealloc_page(page);
+}
+
+/* FRAME의 내용이 뒤에 있는 저장소와 같아 쓰지 않고 바로 버릴 수 있으면
+ * true. 파일 페이지는 dirty 비트만 보면 되고, 익명 페이지는 스왑 캐시에
+ * 슬롯이나 패턴이 남아 있어야 합니다. frame_lock을 잡은 상태에서 호출합니다. */
+static bool
+vm_frame_is_clean(struct frame *frame)
+{
+	struct page *page = frame->page;
+
+	if (pml4_is_dirty(frame->owner->pml4, page->va))
+		return false;
+	if (VM_TYPE(page->operations->type) == VM_ANON)
+		return page->anon.patterned || page->anon.swap_idx != SWAP_NONE;
 	return true;
 }
 
-/* 앞으로 쫓아낼 프레임을 얻습니다. 야호 야호 야호 */
+/* 앞으로 쫓아낼 프레임을 얻습니다. 야호 야호 야호
+ * frame table을 시계처럼 돌며(second chance) 최근 접근되지 않은 프레임을
+ * 고릅니다. 맨 앞 프레임을 꺼내 맨 뒤로 보내는 방식이라 리스트 순서가 곧
+ * 시계 바늘 위치입니다. 채우는 중인 프레임과 세탁 중인 프레임은
+ * 건너뜁니다.
+ * CLEAN_ONLY면 깨끗한 프레임만 고르고, 만난 더러운 프레임은 세탁 목록에
+ * 넘겨 세탁 스레드가 미리 기록하게 합니다. frame_lock을 잡은 상태에서
+ * 호출합니다. */
 static struct frame *
-vm_get_victim(void)
+vm_get_victim(bool clean_only)
 {
-	struct frame *victim = NULL;
+	size_t frame_cnt = list_size(&frame_table);
+	size_t i;
 
-	struct thread *curr = thread_current();
-	uint64_t curr_pml4 = curr->pml4;
+	ASSERT(lock_held_by_current_thread(&frame_lock));
 
-	/* TODO: 어떤 프레임을 제거할지는 구현하기 나름입니다. */
-	for (struct list_elem *i = &frame_table.head ; ; i = i->next)
+	/* 한 바퀴 동안 accessed 비트를 지우므로 두 바퀴 안에 결정된다. */
+	for (i = 0; i < 2 * frame_cnt; i++)
 	{
-		victim = list_entry(i, struct frame, frame_elem);
-		void *upage = victim->page->va;
-		if (pml4_is_accessed (curr_pml4, upage))
+		struct list_elem *e = list_pop_front(&frame_table);
+		struct frame *victim = list_entry(e, struct frame, frame_elem);
+		struct page *page = victim->page;
+
+		list_push_back(&frame_table, e);
+
+		if (victim->pinned || victim->in_laundry || page == NULL)
+			continue;
+
+		/* 공유 프레임은 매핑한 모든 프로세스의 비트를 본다. 세탁은 한
+		 * pml4만 다루므로 더러운 공유 프레임은 세탁 목록에 넘기지 않고,
+		 * 깨끗한 프레임이 없을 때 교체 경로에서 직접 기록한다. */
+		if (page->operations->type == VM_FILE && page->file.shared != NULL)
 		{
-			pml4_set_accessed (curr_pml4, upage, false);
+			if (!file_shared_test_accessed(page) &&
+				(!clean_only || !file_shared_is_dirty(page)))
+				return victim;
+			continue;
 		}
+
+		if (pml4_is_accessed(victim->owner->pml4, page->va))
+			pml4_set_accessed(victim->owner->pml4, page->va, false);
+		else if (!clean_only || vm_frame_is_clean(victim))
+			return victim;
 		else
 		{
-			return victim;
+			victim->in_laundry = true;
+			list_push_back(&laundry_list, &victim->laundry_elem);
+			laundry_cnt++;
+			cond_signal(&laundry_cond, &frame_lock);
 		}
 	}
-	
-	NOT_REACHED();
 	return NULL;
 }
 
 /* 한 페이지를 교체하고 그에 해당하는 프레임을 반환합니다.
- * 실패하면 NULL을 반환합니다.*/
+ * 실패하면 NULL을 반환합니다.
+ * 깨끗한 프레임을 먼저 찾아 쓰기 없이 버립니다. 없으면 세탁 스레드가 한
+ * 묶음을 끝낼 때까지 기다렸다 다시 찾으므로, 폴트를 낸 스레드가 직접
+ * 더러운 페이지를 기록하는 일은 세탁이 따라가지 못할 때로 한정됩니다.
+ * 세탁 스레드는 파일 페이지를 filesys_lock 아래에서 기록하므로, 그 락을
+ * 쥔 채 폴트를 낸 스레드(read()의 사용자 버퍼 등)는 기다리지 않습니다.
+ * 직접 기록할 때도 victim을 frame table에서 빼고 laundering을 켠 뒤
+ * frame_lock을 놓고 기록하므로, 다른 스레드의 폴트와 할당은 이 기록을
+ * 기다리지 않습니다. */
 static struct frame *
 vm_evict_frame(void)
 {
-	struct frame *victim UNUSED = vm_get_victim();
-	/* TODO: victim을 swap 영역으로 내보내고, 그 프레임을 반환하세요. */
+	struct frame *victim;
+	struct page *page;
+	bool may_wait = !lock_held_by_current_thread(&filesys_lock);
+	bool success;
+	int retry;
+
+	lock_acquire(&frame_lock);
+	victim = vm_get_victim(true);
+	for (retry = 0; victim == NULL && may_wait && laundry_cnt > 0 && retry < LAUNDRY_RETRY; retry++)
+	{
+		cond_wait(&laundry_done, &frame_lock);
+		victim = vm_get_victim(true);
+	}
+	if (victim == NULL)
+		victim = vm_get_victim(false);
 
-	enum vm_type type = victim->page->operations->type;
-	if (VM_TYPE(type) == VM_FILE)
+	/* 기록하는 동안 다른 교체나 압축이 고르지 않도록 frame table에서 빼고,
+	 * 해제 경로와 이 페이지의 폴트는 laundering을 보고 기다리게 한다. */
+	if (victim != NULL)
 	{
-		file_backed_destroy(&victim->page);
+		list_remove(&victim->frame_elem);
+		victim->laundering = true;
 	}
+	lock_release(&frame_lock);
+	if (victim == NULL)
+		return NULL;
 
+	/* victim을 swap 영역(파일 페이지는 파일)으로 내보내고 페이지와의 연결을 끊는다.
+	 * 공유 프레임은 swap_out이 모든 매퍼와의 연결을 끊고 victim->page를 비운다. */
+	page = victim->page;
+	success = swap_out(page);
 
-	return NULL;
+	lock_acquire(&frame_lock);
+	victim->laundering = false;
+	if (success)
+	{
+		if (victim->page != NULL)
+			victim->page->frame = NULL;
+		victim->page = NULL;
+		evict_cnt++;
+	}
+	else
+		list_push_back(&frame_table, &victim->frame_elem);
+	cond_broadcast(&laundry_done, &frame_lock);
+	lock_release(&frame_lock);
+
+	return success ? victim : NULL;
+}
+
+/* FRAME을 다른 물리 페이지로 옮길 수 있으면 true. 채우는 중이거나 세탁
+ * 중인 프레임은 누군가 kva를 직접 쓰고 있고, 공유 프레임은 여러 pml4가
+ * 가리키므로 옮기지 않습니다. frame_lock을 잡은 상태에서 호출합니다. */
+static bool
+vm_frame_is_movable(struct frame *frame)
+{
+	struct page *page = frame->page;
+
+	return !frame->pinned && !frame->in_laundry && page != NULL &&
+		   !(page->operations->type == VM_FILE && page->file.shared != NULL);
+}
+
+/* 메모리에 있는 PAGE의 내용을 물리 페이지 KVA로 옮기고 소유 프로세스의
+ * PTE가 KVA를 가리키게 합니다. frame 구조체는 그대로 두고 kva만 바꾸므로
+ * page와 frame의 연결은 유지되며, 원래 물리 페이지는 호출자가 처리합니다.
+ * 옮길 수 없는 프레임이면 false를 반환합니다.
+ * frame_lock을 잡은 상태에서 호출합니다. */
+bool
+vm_migrate_page(struct page *page, void *kva)
+{
+	struct frame *frame = page->frame;
+	uint64_t *pml4;
+	uint64_t *pte;
+	enum intr_level old_level;
+	bool dirty, accessed;
+
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	if (frame == NULL || !vm_frame_is_movable(frame))
+		return false;
+	pml4 = frame->owner->pml4;
+
+	/* 2MB 매핑 안의 페이지면 여기서 PDE가 쪼개진다. 쪼갤 때 페이지
+	 * 테이블을 할당하므로 인터럽트를 끄기 전에 해 둔다. */
+	pte = pml4e_walk(pml4, (uint64_t)page->va, 0);
+	if (pte == NULL || !(*pte & PTE_P))
+		return false;
+
+	/* 복사와 PTE 교체 사이에 소유 프로세스가 옛 페이지에 쓰지 못하게 한다.
+	 * 새 PTE에 dirty/accessed 비트를 옮겨 두어야 교체와 세탁이 제대로
+	 * 판단하며, pml4_set_dirty()는 활성 pml4면 TLB 항목도 지운다. */
+	old_level = intr_disable();
+	dirty = pml4_is_dirty(pml4, page->va);
+	accessed = pml4_is_accessed(pml4, page->va);
+	memcpy(kva, frame->kva, PGSIZE);
+	pml4_set_page(pml4, page->va, kva, is_writable(pte));
+	pml4_set_accessed(pml4, page->va, accessed);
+	pml4_set_dirty(pml4, page->va, dirty);
+	intr_set_level(old_level);
+
+	frame->kva = kva;
+	return true;
+}
+
+/* 사용자 풀에서 2MB 정렬된 구간 하나를 비워 통째로 할당해 돌려줍니다.
+ * 할당된 페이지가 모두 옮길 수 있는 사용자 프레임인 구간 가운데 옮길
+ * 페이지가 가장 적은 곳을 고릅니다. 구간의 빈 페이지를 먼저 선점해 새
+ * 페이지가 구간 안에 잡히지 않게 한 뒤, 각 프레임을 구간 밖의 페이지로
+ * 옮깁니다. 성공하면 palloc_get_aligned(PAL_USER | PAL_ZERO, HUGE_PGCNT,
+ * HUGE_PGCNT)와 같이 0으로 채운 구간을 반환하고, 중간에 실패하면 선점한
+ * 페이지를 모두 돌려주고 NULL을 반환합니다. */
+void *
+vm_compact(void)
+{
+	uint8_t *pool_base, *pool_end, *start, *run = NULL;
+	size_t pool_cnt, win_cnt, best_used = SIZE_MAX, w, i;
+	size_t *movable;
+	struct bitmap *claimed;
+	struct list_elem *e;
+
+	palloc_user_bounds((void **)&pool_base, &pool_cnt);
+	pool_end = pool_base + pool_cnt * PGSIZE;
+	start = (uint8_t *)ROUND_UP((uint64_t)pool_base, HUGE_PGSIZE);
+	if (start + HUGE_PGSIZE > pool_end)
+		return NULL;
+	win_cnt = (pool_end - start) / HUGE_PGSIZE;
+
+	movable = calloc(win_cnt, sizeof *movable);
+	claimed = bitmap_create(HUGE_PGCNT);
+	if (movable == NULL || claimed == NULL)
+		goto done;
+
+	lock_acquire(&frame_lock);
+
+	/* 구간별로 옮길 수 있는 프레임 수를 센다. 할당된 페이지 수와 같아야
+	 * 구간을 다 비울 수 있다. */
+	for (e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e))
+	{
+		struct frame *frame = list_entry(e, struct frame, frame_elem);
+		uint8_t *kva = frame->kva;
+
+		if (vm_frame_is_movable(frame) && kva >= start &&
+			(w = (kva - start) / HUGE_PGSIZE) < win_cnt)
+			movable[w]++;
+	}
+	for (w = 0; w < win_cnt; w++)
+	{
+		size_t used = palloc_user_count_used(start + w * HUGE_PGSIZE, HUGE_PGCNT);
+
+		if (used == movable[w] && used < best_used)
+		{
+			best_used = used;
+			run = start + w * HUGE_PGSIZE;
+		}
+	}
+
+	if (run != NULL)
+	{
+		palloc_user_claim_free(run, HUGE_PGCNT, claimed);
+		for (e = list_begin(&frame_table); e != list_end(&frame_table); e = list_next(e))
+		{
+			struct frame *frame = list_entry(e, struct frame, frame_elem);
+			uint8_t *old = frame->kva;
+			void *kva;
+
+			if (old < run || old >= run + HUGE_PGSIZE || !vm_frame_is_movable(frame))
+				continue;
+
+			kva = palloc_get_page(PAL_USER);
+			if (kva == NULL)
+				break;
+			if (!vm_migrate_page(frame->page, kva))
+			{
+				palloc_free_page(kva);
+				break;
+			}
+			bitmap_mark(claimed, (old - run) / PGSIZE);
+		}
+
+		/* 세는 사이 다른 스레드가 구간에 페이지를 받아 갔거나 옮길 자리가
+		 * 모자라면 선점한 페이지를 돌려준다. */
+		if (!bitmap_all(claimed, 0, HUGE_PGCNT))
+		{
+			for (i = 0; i < HUGE_PGCNT; i++)
+				if (bitmap_test(claimed, i))
+					palloc_free_page(run + i * PGSIZE);
+			run = NULL;
+		}
+	}
+	lock_release(&frame_lock);
+
+	if (run != NULL)
+		memset(run, 0, HUGE_PGSIZE);
+done:
+	free(movable);
+	if (claimed != NULL)
+		bitmap_destroy(claimed);
+	return run;
+}
+
+/* 세탁 묶음을 소유 프로세스, 가상 주소 순으로 정렬한다. 익명 페이지는
+ * 이 순서대로 슬롯을 받으므로 스왑 장치에도 이웃한 자리에 기록된다. */
+static bool
+laundry_less(const struct list_elem *a_, const struct list_elem *b_,
+			 void *aux UNUSED)
+{
+	const struct frame *a = list_entry(a_, struct frame, laundry_elem);
+	const struct frame *b = list_entry(b_, struct frame, laundry_elem);
+
+	if (a->owner != b->owner)
+		return a->owner < b->owner;
+	return a->page->va < b->page->va;
+}
+
+/* 세탁 스레드. 세탁 목록에서 최대 LAUNDRY_BATCH개의 프레임을 꺼내 주소
+ * 순으로 정렬한 뒤 frame_lock을 놓고 내용을 기록합니다. 기록이 끝난
+ * 프레임은 dirty 비트가 꺼진 깨끗한 상태로 frame table에 남아 다음 교체
+ * 때 바로 버릴 수 있습니다. 기록 중에는 laundering이 켜져 있어 해제
+ * 경로가 vm_frame_settle()에서 기다립니다. */
+static void
+laundry_writer(void *aux UNUSED)
+{
+	struct list batch;
+	struct list_elem *e;
+
+	list_init(&batch);
+	lock_acquire(&frame_lock);
+	for (;;)
+	{
+		while (list_empty(&laundry_list))
+			cond_wait(&laundry_cond, &frame_lock);
+
+		while (!list_empty(&laundry_list) && list_size(&batch) < LAUNDRY_BATCH)
+		{
+			struct frame *frame = list_entry(list_pop_front(&laundry_list),
+											 struct frame, laundry_elem);
+			frame->laundering = true;
+			list_push_back(&batch, &frame->laundry_elem);
+		}
+		list_sort(&batch, laundry_less, NULL);
+		lock_release(&frame_lock);
+
+		for (e = list_begin(&batch); e != list_end(&batch); e = list_next(e))
+		{
+			struct page *page = list_entry(e, struct frame, laundry_elem)->page;
+
+			if (VM_TYPE(page->operations->type) == VM_ANON)
+				anon_launder(page);
+			else
+				file_backed_launder(page);
+		}
+
+		lock_acquire(&frame_lock);
+		while (!list_empty(&batch))
+		{
+			struct frame *frame = list_entry(list_pop_front(&batch),
+											 struct frame, laundry_elem);
+			frame->laundering = false;
+			frame->in_laundry = false;
+			laundry_cnt--;
+		}
+		cond_broadcast(&laundry_done, &frame_lock);
+	}
+}
+
+/* PAGE의 프레임을 해제하기 전에 세탁과 정리합니다. 세탁 스레드나 교체
+ * 경로가 기록 중이면 끝날 때까지 기다리고, 세탁 목록에서 기다리는 중이면 목록에서
+ * 뺍니다. 기다리는 동안 프레임이 쫓겨날 수 있으므로 그 뒤의 프레임을
+ * 반환합니다. frame_lock을 잡은 상태에서 호출합니다. */
+struct frame *
+vm_frame_settle(struct page *page)
+{
+	struct frame *frame;
+
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	while ((frame = page->frame) != NULL && frame->laundering)
+		cond_wait(&laundry_done, &frame_lock);
+
+	if (frame != NULL && frame->in_laundry)
+	{
+		list_remove(&frame->laundry_elem);
+		frame->in_laundry = false;
+		laundry_cnt--;
+	}
+	return frame;
 }
 
 /* palloc()을 이용해 프레임을 얻습니다. 남는 프레임이 없다면 하나를
  * 해제하여 돌려줍니다. 즉 사용자 풀 메모리가 가득 차도 이 함수는
- * 프레임을 얻기 위해 기존 페이지를 해제한 뒤 유효한 주소를 반환합니다.*/
+ * 프레임을 얻기 위해 기존 페이지를 해제한 뒤 유효한 주소를 반환합니다.
+ * 반환한 프레임은 pinned 상태이며, 내용을 다 채운 뒤 호출자가 풉니다. */
 static struct frame *
 vm_get_frame(void)
 {
+	struct frame *new_frame;
+	void *kva = palloc_get_page(PAL_USER | PAL_ZERO);
 
-	/* frame 구조체와 실제 물리 페이지를 준비한다. */
-	struct frame *new_frame = malloc(sizeof(struct frame));
-	if (new_frame == NULL)
-		return NULL;
-
-	new_frame->kva = palloc_get_page(PAL_USER | PAL_ZERO);
-	if (new_frame->kva == NULL)
+	if (kva != NULL)
 	{
-		free(new_frame);
-		return NULL;
+		/* frame 구조체와 실제 물리 페이지를 준비한다. */
+		new_frame = malloc(sizeof(struct frame));
+		if (new_frame == NULL)
+		{
+			palloc_free_page(kva);
+			return NULL;
+		}
+		new_frame->kva = kva;
+	}
+	else
+	{
+		/* 할당할 frame이 없으면 교체 로직 호출 */
+		new_frame = vm_evict_frame();
+		if (new_frame == NULL)
+			return NULL;
+		memset(new_frame->kva, 0, PGSIZE);
 	}
 
 	/* frame 구조체 초기 값 설정 */
 	new_frame->page = NULL;
-
-	/* 할당할 frame이 없으면 교체 로직 호출(추가 구현) */
+	new_frame->owner = thread_current();
+	new_frame->pinned = true;
+	new_frame->in_laundry = false;
+	new_frame->laundering = false;
 
 	/* 할당받은 frame을 frame table에 삽입 */
-	list_push_front(&frame_table, &new_frame->frame_elem);
+	lock_acquire(&frame_lock);
+	list_push_back(&frame_table, &new_frame->frame_elem);
+	lock_release(&frame_lock);
 
 	ASSERT(new_frame != NULL);
 	ASSERT(new_frame->page == NULL);
@@ -291,6 +759,8 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 		if (addr < USER_STACK && addr >= (rsp - 8) && addr >= (void *)(USER_STACK - (1 << 20)))
 		{
 			vm_stack_growth(addr);
+			fault_cnt++;
+			curr->mstat.minor_faults++;
 			return true;
 		}
 		else
@@ -300,7 +770,36 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 	// if (write && !page->writable) // !!!!!!!!!!!!!!!!!!!!!!!!!!
 	// 	return false;			  // 쓰기 권한이 없는 페이지에 write 접근
 
-	return vm_do_claim_page(page);
+	/* 교체 경로가 frame_lock 밖에서 이 페이지를 내보내는 중이라 매핑이 먼저
+	 * 사라졌으면 기록이 끝날 때까지 기다린다. 내보내기가 실패해 매핑이
+	 * 되살아났으면 그대로 다시 실행하고, 프레임과 매핑이 모두 있는데 난
+	 * 폴트는 권한 위반이다. */
+	bool waited = false, resident;
+
+	lock_acquire(&frame_lock);
+	while (page->frame != NULL && page->frame->laundering &&
+		   pml4_get_page(curr->pml4, page->va) == NULL)
+	{
+		cond_wait(&laundry_done, &frame_lock);
+		waited = true;
+	}
+	resident = page->frame != NULL;
+	lock_release(&frame_lock);
+	if (resident)
+		return waited;
+
+	bool major = vm_fault_is_major(page);
+
+	/* 2MB 단위로 묶을 수 있는 익명 영역이면 폴트 한 번에 구간 전체를 올린다. */
+	if (!vm_claim_huge_page(page) && !vm_do_claim_page(page))
+		return false;
+
+	fault_cnt++;
+	if (major)
+		curr->mstat.major_faults++;
+	else
+		curr->mstat.minor_faults++;
+	return true;
 }
 
 /* 페이지를 해제합니다.
@@ -329,6 +828,19 @@ bool vm_claim_page(void *va UNUSED)
 /* 확보한 PAGE를 FRAME에 매핑하여 MMU 설정을 완료합니다. */
 static bool
 vm_do_claim_page(struct page *page)
+{
+	bool success = vm_claim_pinned(page);
+
+	/* 내용을 다 채웠으니 이제 교체 대상이 될 수 있다. */
+	if (page->frame != NULL)
+		page->frame->pinned = false;
+	return success;
+}
+
+/* vm_do_claim_page()와 같지만 프레임을 pinned 상태로 남겨 둡니다.
+ * 호출자가 내용을 더 채운 뒤 직접 풀어야 합니다. */
+static bool
+vm_claim_pinned(struct page *page)
 {
 	/* 매핑할 frame 획득 */
 	struct frame *frame = vm_get_frame();
@@ -353,6 +865,168 @@ vm_do_claim_page(struct page *page)
 	return swap_in(page, frame->kva);
 }
 
+/* PAGE가 아직 올라오지 않은, 쓰기 가능한 0-채움 익명 페이지인지 확인합니다.
+ * 파일에서 읽을 내용이 없는 BSS 페이지(lazy_load_segment, page_read_bytes
+ * == 0)와 initializer가 없는 익명 페이지가 여기에 해당합니다. */
+static bool
+vm_is_zero_anon(struct page *page)
+{
+	if (page == NULL || page->frame != NULL || !page->writable)
+		return false;
+	if (VM_TYPE(page->operations->type) != VM_UNINIT ||
+		VM_TYPE(page->uninit.type) != VM_ANON)
+		return false;
+	if (page->uninit.init == NULL)
+		return true;
+	return page->uninit.init == lazy_load_segment &&
+		   ((struct aux *)page->uninit.aux)->page_read_bytes == 0;
+}
+
+/* BASE부터 2MB 구간의 페이지가 모두 0-채움 익명 페이지인지 검사하고,
+ * 구간에 있는 페이지마다 검사했다고 표시합니다. 이미 표시된 페이지에서
+ * 난 폴트는 다시 검사하지 않으므로 512번의 조회는 구간마다 한 번이며,
+ * 구간에 페이지가 새로 생기면 그 페이지의 폴트에서 다시 검사합니다. */
+static bool
+vm_huge_region_ok(struct supplemental_page_table *spt, uint8_t *base)
+{
+	bool ok = true;
+
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		if (p != NULL)
+			p->huge_checked = true;
+		if (!vm_is_zero_anon(p))
+			ok = false;
+	}
+	return ok;
+}
+
+/* PAGE를 포함한 2MB 정렬 구간이 모두 0-채움 익명 페이지로 이루어져 있으면
+ * 연속된 2MB 물리 페이지 하나를 할당해 PDE 하나로 매핑합니다. 각 4KB
+ * 페이지는 블록 안의 자기 위치를 가리키는 frame을 따로 가지므로, 이후
+ * 교체나 해제는 4KB 단위로 이뤄지고 그때 mmu가 PDE를 쪼갭니다.
+ * 조건이 맞지 않거나 연속된 물리 메모리가 없거나 초기화에 실패하면 매핑과
+ * 프레임을 모두 되돌리고 false를 반환하며, 호출자는 4KB 경로로 처리합니다. */
+static bool
+vm_claim_huge_page(struct page *page)
+{
+	struct thread *curr = thread_current();
+	struct supplemental_page_table *spt = &curr->spt;
+	uint8_t *base = (uint8_t *)((uint64_t)page->va & ~(HUGE_PGSIZE - 1));
+	struct list frames;
+	uint8_t *kva;
+	bool success = true;
+	size_t i;
+
+	if (!vm_is_zero_anon(page) || page->huge_checked)
+		return false;
+	if (!vm_huge_region_ok(spt, base))
+		return false;
+
+	/* 연속된 구간이 없으면 사용자 프레임을 옮겨 하나 만들어 본다. */
+	kva = palloc_get_aligned(PAL_USER | PAL_ZERO, HUGE_PGCNT, HUGE_PGCNT);
+	if (kva == NULL)
+		kva = vm_compact();
+	if (kva == NULL)
+		return false;
+
+	/* 매핑 전에 frame 구조체를 모두 확보해 두어야 중간 실패를 되돌릴 수 있다. */
+	list_init(&frames);
+	for (i = 0; i < HUGE_PGCNT; i++)
+	{
+		struct frame *frame = malloc(sizeof(struct frame));
+		if (frame == NULL)
+			break;
+		list_push_back(&frames, &frame->frame_elem);
+	}
+
+	if (i < HUGE_PGCNT || !pml4_set_huge_page(curr->pml4, base, kva, true))
+	{
+		while (!list_empty(&frames))
+			free(list_entry(list_pop_front(&frames), struct frame, frame_elem));
+		palloc_free_multiple(kva, HUGE_PGCNT);
+		return false;
+	}
+
+	/* 모두 채울 때까지 pinned로 두어 중간에 교체되거나 옮겨지지 않게 한다. */
+	for (i = 0; i < HUGE_PGCNT; i++)
+	{
+		struct frame *frame = list_entry(list_pop_front(&frames), struct frame, frame_elem);
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+
+		frame->kva = kva + i * PGSIZE;
+		frame->page = p;
+		frame->owner = curr;
+		frame->pinned = true;
+		frame->in_laundry = false;
+		frame->laundering = false;
+		p->frame = frame;
+		lock_acquire(&frame_lock);
+		list_push_back(&frame_table, &frame->frame_elem);
+		lock_release(&frame_lock);
+	}
+	for (i = 0; i < HUGE_PGCNT && success; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		success = swap_in(p, p->frame->kva);
+	}
+
+	lock_acquire(&frame_lock);
+	for (i = 0; i < HUGE_PGCNT; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+
+		if (success)
+		{
+			p->frame->pinned = false;
+			continue;
+		}
+
+		/* 되돌린다. 이미 익명 페이지로 바뀐 페이지는 0 패턴으로 남겨 두어
+		 * 다음 폴트 때 4KB 경로에서 0으로 다시 만든다. */
+		list_remove(&p->frame->frame_elem);
+		free(p->frame);
+		p->frame = NULL;
+		if (VM_TYPE(p->operations->type) == VM_ANON)
+		{
+			p->anon.patterned = true;
+			p->anon.pattern = 0;
+		}
+	}
+	lock_release(&frame_lock);
+
+	if (!success)
+	{
+		pml4_clear_huge_page(curr->pml4, base);
+		palloc_free_multiple(kva, HUGE_PGCNT);
+	}
+	return success;
+}
+
+/* 자식의 DST_PAGE에 프레임을 붙이고 부모 SRC_PAGE의 내용을 복사합니다.
+ * 자식의 프레임을 얻는 과정에서 부모의 페이지가 쫓겨날 수 있으므로,
+ * frame_lock을 잡은 채 부모 페이지가 메모리에 있으면 프레임에서, 스왑에
+ * 나가 있으면 스왑 슬롯에서 읽어 옵니다. 쫓겨난 파일 페이지는 이미 파일에
+ * 기록되었으므로 claim 때 파일에서 읽어 온 내용 그대로 둡니다. */
+static bool
+spt_copy_page(struct page *dst_page, struct page *src_page)
+{
+	if (dst_page == NULL || !vm_claim_pinned(dst_page))
+		return false;
+
+	lock_acquire(&frame_lock);
+	if (src_page->frame != NULL)
+		memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
+	else if (VM_TYPE(src_page->operations->type) == VM_ANON)
+		anon_swap_read(src_page, dst_page->frame->kva);
+	lock_release(&frame_lock);
+
+	dst_page->frame->pinned = false;
+	thread_current()->mstat.fork_copied++;
+	return true;
+}
+
 /* 새로운 supplemental page table을 초기화합니다 */
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 {
@@ -379,8 +1053,7 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 	/* src_hi의 hash_elem을 dst의 hash_table의 첫번째 bucket, 첫번째 hash_elem으로 설정 */
 	hash_first(&src_hi, &src->hash_table);
 
-	struct aux *_aux;
-	struct page *dst_page;
+	void *_aux;
 	
 	/* dst의 hash_table을 순회하며, page 복사 */
 	while (hash_next(&src_hi))
@@ -394,38 +1067,46 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 			/* uninit인 경우 */ 			
 			case VM_UNINIT:
 				_aux = temp_page->uninit.aux;
+
+				/* 파일 매핑 페이지는 매핑 기술자를 자식과 함께 참조한다. */
+				if (VM_TYPE(temp_page->uninit.type) == VM_FILE)
+					mmap_desc_get((struct mmap_desc *) _aux);
 				vm_alloc_page_with_initializer(temp_page->uninit.type, temp_page->va, temp_page->writable, temp_page->uninit.init, _aux);
 				
 				/* uninit은 메모리에 로드되지 않은 페이지라, vm_claim_page() 호출 없이 종료 */
 				break;
 			
-			/* file인 경우, aux 전달 */
+			/* file인 경우, 매핑 기술자 참조를 하나 늘려 전달 */
 			case VM_FILE:
-				_aux = temp_page->file.aux;
-				vm_alloc_page_with_initializer(VM_FILE, temp_page->va, temp_page->writable, lazy_load_segment, _aux);
+				_aux = mmap_desc_get(temp_page->file.desc);
+
+				/* 공유 매핑은 자식도 같은 공유 프레임을 매핑하므로 내용 복사가 필요 없다. */
+				if (temp_page->file.shared != NULL)
+				{
+					vm_alloc_page_with_initializer(VM_FILE | VM_MARKER_1, temp_page->va, temp_page->writable, lazy_load_shared, _aux);
+					if (!vm_claim_page(temp_page->va))
+						return false;
+					break;
+				}
+
+				vm_alloc_page_with_initializer(VM_FILE, temp_page->va, temp_page->writable, lazy_load_mmap, _aux);
 				
-				/* spt 등록 후 frame 연결 */
-				if (!vm_claim_page(temp_page->va))
+				/* spt 등록 후 frame 연결 및 내용 복사 */
+				if (!spt_copy_page(spt_find_page(dst, temp_page->va), temp_page))
 					return false;
-				
-				/* frame 연결 후, 해당 frame이 가리키는 kva(물리 메모리 주소)에 쓰인 데이터 복사 */ 
-				dst_page = spt_find_page(dst, temp_page->va);
-				memcpy(dst_page->frame->kva, temp_page->frame->kva, PGSIZE);
 
 				break;
 
-			/* 그 외 (VM_ANON인 경우) */
+			/* 그 외 (VM_ANON인 경우), 익명 mmap 페이지는 매핑 시작 주소도 함께 복사 */
 			default:
-				vm_alloc_page_with_initializer(VM_ANON, temp_page->va, temp_page->writable, NULL, NULL);
+				_aux = temp_page->anon.mmap_base;
+				vm_alloc_page_with_initializer(_aux != NULL ? VM_ANON | VM_MARKER_1 : VM_ANON,
+											   temp_page->va, temp_page->writable, NULL, _aux);
 				
-				/* spt 등록 후 frame 연결 */
-				if (!vm_claim_page(temp_page->va))
+				/* spt 등록 후 frame 연결 및 내용 복사 */
+				if (!spt_copy_page(spt_find_page(dst, temp_page->va), temp_page))
 					return false;
 				
-				/* frame 연결 후, 해당 frame이 가리키는 kva(물리 메모리 주소)에 쓰인 데이터 복사 */ 
-				dst_page = spt_find_page(dst, temp_page->va);
-				memcpy(dst_page->frame->kva, temp_page->frame->kva, PGSIZE);					
-				
 				break;
 		}
 	}
@@ -436,21 +1117,64 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 	return success;
 }
 
-void page_clear(struct hash_elem *e, void *aux)
+/* hash_clear()가 버킷에서 떼어낸 페이지를 AUX 리스트로 옮긴다.
+ * hash_elem 안의 list_elem을 그대로 재사용하므로 항목별 hash_delete가 없다. */
+static void
+page_collect(struct hash_elem *e, void *aux)
 {
-	struct page *temp_page = hash_entry(e, struct page, hash_elem);
-	vm_dealloc_page(temp_page);
+	list_push_back((struct list *)aux, &e->list_elem);
 }
 
-/* supplemental page table이 가진 자원을 해제합니다 */
+/* supplemental page table이 가진 자원을 해제합니다.
+ * process_cleanup()에서만 불리며 바로 뒤에 pml4_destroy()가 이어집니다.
+ * 그래서 프레임의 PTE와 kva는 여기서 하나씩 지우지 않고, pml4_destroy()가
+ * 페이지 테이블을 한 번 훑을 때 함께 반납되도록 남겨 둡니다. */
 void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED)
 {
-	/* TODO: 스레드가 보유한 모든 supplemental_page_table을 파괴하고
-	 * TODO: 수정된 내용을 저장소에 모두 반영하세요. */
+	struct list pages;
+	void *hash_aux = spt->hash_table.aux;
 
 	// destroy하면 안됨. -> exec 중간에 사용할 수 있기 때문에!
 	// 일단 clear만 해줌.
-	hash_clear(&spt->hash_table, page_clear);
+	list_init(&pages);
+	spt->hash_table.aux = &pages;
+	hash_clear(&spt->hash_table, page_collect);
+	spt->hash_table.aux = hash_aux;
+
+	/* 공유 매핑 프레임은 다른 프로세스도 쓰므로 destroy에서 떼어낸다.
+	 * 나머지 프레임은 frame_lock을 한 번만 잡고 frame table에서 모두 빼내어
+	 * 이후 write-back 도중 교체되지 않게 한다. 세탁 중인 프레임은 기록이
+	 * 끝나기를 기다린다. */
+	struct list_elem *e;
+	lock_acquire(&frame_lock);
+	for (e = list_begin(&pages); e != list_end(&pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, hash_elem.list_elem);
+		if (vm_frame_settle(page) != NULL &&
+			!(page->operations->type == VM_FILE && page->file.shared != NULL))
+			list_remove(&page->frame->frame_elem);
+	}
+	lock_release(&frame_lock);
+
+	/* 수정된 파일 매핑 페이지는 매핑별로 묶어 연속 구간 단위로 write-back */
+	file_backed_flush(&pages);
+
+	/* 익명 페이지의 스왑 슬롯은 장치별로 모아 swap_lock 한 번에 반납 */
+	anon_swap_free_pages(&pages);
+
+	while (!list_empty(&pages))
+	{
+		struct page *page = list_entry(list_pop_front(&pages), struct page, hash_elem.list_elem);
+
+		/* frame 구조체만 정리하고 destroy가 PTE를 건드리지 않게 한다. */
+		if (page->frame != NULL &&
+			!(page->operations->type == VM_FILE && page->file.shared != NULL))
+		{
+			free(page->frame);
+			page->frame = NULL;
+		}
+		vm_dealloc_page(page);
+	}
 }
 
 /* hash_elem으로 bucket_idx 획득 */